@@ -6,10 +6,14 @@ layout(location = 1) in vec2 textcoord;
 
 out vec2 v_textcoord;
 
-uniform mat4 u_mvp;
+layout(std140) uniform Camera {
+    mat4 u_view_proj;
+};
+
+uniform mat4 u_model;
 
 void main() {
-    gl_Position = u_mvp * position;
+    gl_Position = u_view_proj * u_model * position;
     v_textcoord = textcoord;
 }
 
@@ -1,13 +1,25 @@
 #shader vertex
 #version 330 core
 
-layout(location = 0) in vec4 position;
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec4 color;
+layout(location = 2) in vec2 texcoord;
+layout(location = 3) in int texindex;
 
-uniform mat4 u_mvp;
+out vec4 v_color;
+out vec2 v_texcoord;
+flat out int v_texindex;
+
+layout(std140) uniform Camera {
+    mat4 u_view_proj;
+};
 
 void main()
 {
-    gl_Position = u_mvp * position;
+    gl_Position = u_view_proj * vec4(position, 0.0, 1.0);
+    v_color = color;
+    v_texcoord = texcoord;
+    v_texindex = texindex;
 }
 
 #shader fragment
@@ -15,9 +27,41 @@ void main()
 
 layout(location = 0) out vec4 color;
 
+in vec4 v_color;
+in vec2 v_texcoord;
+flat in int v_texindex;
+
+// must match BatchRenderer2D::kMaxTextureSlots; negative indices are layers of u_array
+uniform sampler2D u_textures[15];
+uniform sampler2DArray u_array;
+
+// GLSL 3.30 only allows constant indices into sampler arrays
+vec4 SampleSlot(int slot, vec2 uv)
+{
+    if (slot < 0) return texture(u_array, vec3(uv, float(-slot - 1)));
+    switch (slot) {
+    case 0: return texture(u_textures[0], uv);
+    case 1: return texture(u_textures[1], uv);
+    case 2: return texture(u_textures[2], uv);
+    case 3: return texture(u_textures[3], uv);
+    case 4: return texture(u_textures[4], uv);
+    case 5: return texture(u_textures[5], uv);
+    case 6: return texture(u_textures[6], uv);
+    case 7: return texture(u_textures[7], uv);
+    case 8: return texture(u_textures[8], uv);
+    case 9: return texture(u_textures[9], uv);
+    case 10: return texture(u_textures[10], uv);
+    case 11: return texture(u_textures[11], uv);
+    case 12: return texture(u_textures[12], uv);
+    case 13: return texture(u_textures[13], uv);
+    case 14: return texture(u_textures[14], uv);
+    }
+    return vec4(1.0);
+}
+
 void main()
 {
-    color = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+    color = SampleSlot(v_texindex, v_texcoord) * v_color;
 }
 
 // vim: set ft=glsl
@@ -0,0 +1,58 @@
+#shader vertex
+#version 410 core
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec4 color;
+layout(location = 2) in vec2 texcoord;
+layout(location = 3) in int texindex;
+
+out vec4 v_color;
+out vec2 v_texcoord;
+flat out int v_texindex;
+
+layout(std140) uniform Camera {
+    mat4 u_view_proj;
+};
+
+void main()
+{
+    gl_Position = u_view_proj * vec4(position, 0.0, 1.0);
+    v_color = color;
+    v_texcoord = texcoord;
+    v_texindex = texindex;
+}
+
+#shader fragment
+#version 410 core
+#extension GL_ARB_bindless_texture : require
+#extension GL_NV_gpu_shader5 : require
+
+layout(location = 0) out vec4 color;
+
+in vec4 v_color;
+in vec2 v_texcoord;
+flat in int v_texindex;
+
+// 64 bit texture handles, two per uvec4 because std140 pads array elements to 16 bytes.
+// must match BatchRenderer2D::kMaxBindlessTextures
+layout(std140) uniform BindlessTextures {
+    uvec4 u_handles[512];
+};
+uniform sampler2DArray u_array;
+
+// The index differs per quad. ARB_bindless_texture alone leaves a sampler built from a non-uniform
+// handle undefined; NV_gpu_shader5 makes it well defined, and the renderer only uses this shader with it
+vec4 SampleSlot(int slot, vec2 uv)
+{
+    if (slot < 0) return texture(u_array, vec3(uv, float(-slot - 1)));
+    uvec4 pair = u_handles[slot >> 1];
+    uvec2 handle = (slot & 1) == 0 ? pair.xy : pair.zw;
+    return texture(sampler2D(handle), uv);
+}
+
+void main()
+{
+    color = SampleSlot(v_texindex, v_texcoord) * v_color;
+}
+
+// vim: set ft=glsl
@@ -0,0 +1,27 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+
+layout(std140) uniform Camera {
+    mat4 u_view_proj;
+};
+
+uniform mat4 u_model;
+
+void main()
+{
+    gl_Position = u_view_proj * u_model * position;
+}
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+void main()
+{
+    color = vec4(1.0f, 0.0f, 1.0f, 1.0f);
+}
+
+// vim: set ft=glsl
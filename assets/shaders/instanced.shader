@@ -0,0 +1,37 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec2 textcoord;
+// Per instance: the model matrix takes locations 2..5, one column each
+layout(location = 2) in mat4 i_model;
+layout(location = 6) in vec4 i_color;
+
+out vec2 v_textcoord;
+out vec4 v_color;
+
+layout(std140) uniform Camera {
+    mat4 u_view_proj;
+};
+
+void main() {
+    gl_Position = u_view_proj * i_model * position;
+    v_textcoord = textcoord;
+    v_color = i_color;
+}
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec2 v_textcoord;
+in vec4 v_color;
+
+uniform sampler2D u_texture;
+
+void main() {
+    color = texture(u_texture, v_textcoord) * v_color;
+}
+
+// vim: ft=glsl
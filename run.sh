@@ -15,6 +15,10 @@ if [ "$1" = "debug" ]; then
   ${DEBUGGER} "./${BUILD_DIR}/${PROJECT_NAME}"
 elif [ "$1" = "cherno" ]; then
   make cherno -j"$(nproc)" -C "${BUILD_DIR}" && "./${BUILD_DIR}/cherno"
+elif [ "$1" = "bench" ]; then
+  make cherno_bench -j"$(nproc)" -C "${BUILD_DIR}" && "./${BUILD_DIR}/cherno_bench" "${@:2}"
+elif [ "$1" = "jobbench" ]; then
+  make job_bench -j"$(nproc)" -C "${BUILD_DIR}" && "./${BUILD_DIR}/job_bench" "${@:2}"
 elif [ "$1" = "opgl" ]; then
   make opgl -j"$(nproc)" -C "${BUILD_DIR}" && "./${BUILD_DIR}/opgl"
 fi
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "glm/glm.hpp"
+#include "index_buffer.h"
+#include "sampler.h"
+#include "shader.h"
+#include "texture.h"
+#include "texture_array.h"
+#include "texture_atlas.h"
+#include "vertex_array.h"
+#include "vertex_buffer.h"
+
+// 20 bytes instead of 36 with every attribute a float. Colors and texture coordinates are normalized
+// integers, so tints are clamped to [0, 1]
+struct QuadVertex {
+  glm::vec2 position;
+  glm::u8vec4 color;
+  glm::u16vec2 tex_coord;
+  int16_t tex_index;  // read as an int; negative values are layers of the array slot
+};
+
+// Collects quads into one streaming vertex buffer and draws them with a single call per batch.
+// A batch is flushed when it runs out of quads or texture slots, when a quad needs a different texture
+// array than the one already in the batch, or on EndBatch. Atlas and TextureArray quads only take the
+// array slot, so any number of their images fit in one batch.
+// With bindless textures (ARB_bindless_texture and NV_gpu_shader5) plain textures are passed as 64 bit handles in a uniform
+// block instead of texture units, raising the per-batch limit from kMaxTextureSlots to
+// kMaxBindlessTextures.
+// Positions are transformed by the Camera uniform block, which the caller keeps up to date.
+class BatchRenderer2D {
+public:
+  static constexpr unsigned int kDefaultMaxQuads = 10000;
+  static constexpr unsigned int kMaxTextureSlots = 15;       // must match batch.shader
+  static constexpr unsigned int kMaxBindlessTextures = 1024;  // must match batch_bindless.shader
+  // Texture unit of the sampler2DArray; negative tex_index values select its layers
+  static constexpr unsigned int kArraySlot = kMaxTextureSlots;
+
+  struct Stats {
+    unsigned int draw_calls = 0;
+    unsigned int quad_count = 0;
+    unsigned int culled_count = 0;  // SubmitQuads quads outside the view
+  };
+
+  // A quad for SubmitQuads: untextured, or an image of the atlas passed along
+  struct Sprite {
+    glm::vec2 position;
+    glm::vec2 size;
+    glm::vec4 color;  // tint of atlas images
+    TextureAtlas::Handle image = TextureAtlas::kInvalidHandle;
+  };
+
+  explicit BatchRenderer2D(unsigned int max_quads = kDefaultMaxQuads);
+  ~BatchRenderer2D();
+
+  void BeginBatch();
+  void EndBatch();
+  void Flush();
+
+  void SubmitQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color);
+  void SubmitQuad(const glm::vec2& position, const glm::vec2& size, const Texture& texture,
+                  const glm::vec4& tint = glm::vec4(1.0f));
+  // Draws the atlas image `image`; removed handles are skipped
+  void SubmitQuad(const glm::vec2& position, const glm::vec2& size, const TextureAtlas& atlas,
+                  TextureAtlas::Handle image, const glm::vec4& tint = glm::vec4(1.0f));
+  void SubmitQuad(const glm::vec2& position, const glm::vec2& size, const TextureArray& array, unsigned int layer,
+                  const glm::vec4& tint = glm::vec4(1.0f));
+  // Submits `count` sprites in order, spread over the JobSystem: sprites entirely outside the view rectangle
+  // [view_min, view_max] are culled and the vertices of the rest are written in parallel. `atlas` may be
+  // nullptr when no sprite has an image; removed images are skipped
+  void SubmitQuads(const Sprite* sprites, size_t count, const glm::vec2& view_min, const glm::vec2& view_max,
+                   const TextureAtlas* atlas = nullptr);
+
+  // The two halves of SubmitQuads, which don't need GL. CullSprites writes the indices of the visible sprites
+  // to `visible` and returns how many there are; WriteSprites writes the quads of `count` of them
+  static size_t CullSprites(const Sprite* sprites, size_t count, const glm::vec2& view_min,
+                            const glm::vec2& view_max, const TextureAtlas* atlas, std::vector<uint32_t>& visible);
+  static void WriteSprites(const Sprite* sprites, const uint32_t* indices, size_t count, const TextureAtlas* atlas,
+                           QuadVertex* vertices);
+
+  // Sampler bound to every texture slot on flush; nullptr samples with each texture's own parameters.
+  // Bindless handles always use their texture's parameters, so in that mode it only affects arrays
+  inline void SetSampler(const Sampler* sampler) { sampler_ = sampler; }
+
+  static bool IsBindlessSupported();
+  // Flushes the current batch; ignored when bindless textures aren't supported
+  void SetBindless(bool bindless);
+  inline bool IsBindless() const { return bindless_; }
+
+  // The batch program, or the library's fallback while it is still compiling
+  Shader& GetShader() const;
+  inline const Stats& GetStats() const { return stats_; }
+  inline void ResetStats() { stats_ = Stats(); }
+
+private:
+  void PushQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color, int tex_index,
+                const glm::vec2& uv_min = glm::vec2(0.0f), const glm::vec2& uv_max = glm::vec2(1.0f));
+  int AcquireTextureSlot(const Texture& texture);
+  int AcquireBindlessSlot(const Texture& texture);
+  void AcquireArray(const TextureAtlas* atlas, const TextureArray* array);
+  void BindTextures();
+
+private:
+  unsigned int max_quads_;
+  unsigned int texture_slot_limit_;
+
+  std::unique_ptr<VertexArray> vao_;
+  std::unique_ptr<VertexBuffer> vertex_buffer_;
+  std::unique_ptr<IndexBuffer> index_buffer_;
+  std::unique_ptr<Texture> white_texture_;
+
+  std::vector<QuadVertex> vertices_;
+  std::vector<uint32_t> visible_;  // SubmitQuads scratch
+  unsigned int quad_count_;
+  std::array<const Texture*, kMaxTextureSlots> texture_slots_;
+  unsigned int texture_slot_count_;
+  // What is bound to kArraySlot: an atlas, whose texture changes as it grows, or a TextureArray
+  const TextureAtlas* atlas_;
+  const TextureArray* texture_array_;
+  const Sampler* sampler_;
+
+  bool bindless_;
+  std::vector<uint64_t> bindless_handles_;
+  std::unordered_map<const Texture*, unsigned int> bindless_slots_;
+  unsigned int bindless_buffer_;
+
+  Stats stats_;
+};
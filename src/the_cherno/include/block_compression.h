@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// GPU block compressed formats. Every format stores 4x4 pixel blocks; this file has no GL dependency
+// so the offline compressor can share it.
+enum class BlockFormat {
+  kBC1,        // RGB, 8 bytes per block
+  kBC3,        // RGBA, 16 bytes per block
+  kBC7,        // RGBA, 16 bytes per block (mode 6 only)
+  kETC2_RGB,   // RGB, 8 bytes per block (ETC1 compatible blocks)
+  kETC2_RGBA,  // RGBA, 16 bytes per block (EAC alpha + ETC2 color)
+};
+
+size_t GetBlockBytes(BlockFormat format);
+// Bytes needed for a `width`x`height` image, rounded up to whole blocks
+size_t GetCompressedSize(BlockFormat format, int width, int height);
+unsigned int GetGLInternalFormat(BlockFormat format);
+unsigned int GetGLBaseFormat(BlockFormat format);
+// Returns false for an internal format not listed in BlockFormat
+bool GetBlockFormat(unsigned int gl_internal_format, BlockFormat& format);
+const char* GetBlockFormatName(BlockFormat format);
+
+// Encodes tightly packed RGBA8 pixels. Partial blocks at the right and bottom edges repeat the last
+// row/column
+std::vector<uint8_t> CompressImage(BlockFormat format, const uint8_t* rgba, int width, int height);
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+// Matches the layout glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand {
+  unsigned int count;
+  unsigned int instance_count;
+  unsigned int first_index;
+  int base_vertex;
+  unsigned int base_instance;  // must be 0 without GL 4.2 / ARB_base_instance, ignored by the fallback
+};
+
+struct MeshRange;
+
+// Accumulates indexed draws that share one vertex array, index buffer and program, so
+// Renderer::DrawIndirect can issue them all with a single glMultiDrawElementsIndirect. Without
+// ARB_multi_draw_indirect the same commands go through glMultiDrawElementsBaseVertex instead, which
+// GL 3.3 has, and only instanced commands fall back to one call each.
+class DrawIndirectBuffer {
+public:
+  explicit DrawIndirectBuffer(unsigned int capacity = 1024);
+  virtual ~DrawIndirectBuffer();
+
+  void Add(const DrawElementsIndirectCommand& command);
+  void Add(const MeshRange& mesh, unsigned int instance_count = 1, unsigned int base_instance = 0);
+  void Clear();
+
+  // Uploads the commands added since the last call and binds GL_DRAW_INDIRECT_BUFFER
+  void Bind();
+
+  inline const std::vector<DrawElementsIndirectCommand>& GetCommands() const { return commands_; }
+  inline unsigned int GetCommandCount() const { return (unsigned int)commands_.size(); }
+  inline bool HasInstancedCommands() const { return instanced_commands_ != 0; }
+
+  // glMultiDrawElementsBaseVertex arguments, kept in step with the commands on the fallback path
+  inline const int* GetCounts() const { return counts_.data(); }
+  inline const void* const* GetIndexOffsets() const { return index_offsets_.data(); }
+  inline const int* GetBaseVertices() const { return base_vertices_.data(); }
+
+  static bool IsIndirectSupported();
+
+private:
+  std::vector<DrawElementsIndirectCommand> commands_;
+  std::vector<int> counts_;
+  std::vector<const void*> index_offsets_;
+  std::vector<int> base_vertices_;
+  unsigned int instanced_commands_;
+
+  unsigned int renderer_id_;  // 0 on the fallback path
+  unsigned int capacity_;
+  bool dirty_;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+
+// Measures real time between frames with the steady clock
+class FrameClock {
+public:
+  // Longer frames are clamped, so a breakpoint or a dragged window doesn't turn into one huge step
+  static constexpr double kMaxDelta = 0.25;
+
+  FrameClock();
+
+  // Seconds since the previous Tick, or since construction for the first one
+  double Tick();
+  // Seconds since construction
+  double GetTime() const;
+  inline double GetDelta() const { return delta_; }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  Clock::time_point start_;
+  Clock::time_point last_;
+  double delta_;
+};
+
+// Turns variable frame times into a whole number of fixed simulation steps, so the simulation runs the same
+// at any frame rate. What is left over is the fraction of a step that real time is ahead of the last one,
+// used to interpolate between the previous and the current simulated state when rendering:
+//   for (int i = timestep.Advance(dt); i > 0; i--) Simulate(timestep.GetStep());
+//   Render(mix(previous, current, timestep.GetAlpha()));
+class FixedTimestep {
+public:
+  explicit FixedTimestep(double step = 1.0 / 60.0, int max_steps = 8);
+
+  // Adds `delta` seconds and returns how many steps to run. At most max_steps are returned; time beyond
+  // that is dropped, which slows the simulation down instead of falling further behind every frame
+  int Advance(double delta);
+
+  void SetStep(double step);
+  inline double GetStep() const { return step_; }
+  // In [0, 1)
+  inline float GetAlpha() const { return (float)(accumulator_ / step_); }
+  inline unsigned int GetDroppedSteps() const { return dropped_steps_; }
+
+private:
+  double step_;
+  int max_steps_;
+  double accumulator_;
+  unsigned int dropped_steps_;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+
+enum class PacingMode {
+  kVsync,       // swap interval 1, the driver blocks in SwapBuffers
+  kUncapped,    // swap interval 0, as fast as possible
+  kLimited,     // swap interval 0, frames start no faster than the target rate (sleep, then spin)
+  kLowLatency,  // swap interval 1, each frame starts as late as it can and still make the next vblank
+};
+
+// Decides when a frame may start. Call WaitForFrameStart before polling input, OnFrameSubmitted right before
+// SwapBuffers and OnFramePresented once it returns; the caller applies GetSwapInterval whenever the mode
+// changes.
+//
+// kLowLatency shortens input-to-photon latency under vsync: instead of polling right after the previous
+// swap and then waiting in the next SwapBuffers, it waits first, so input is read closer to the vblank
+// that shows it. The wait is the refresh period minus the slowest recent frame and a safety margin; a
+// frame that takes longer than predicted misses the vblank, like any frame would without the wait.
+class FramePacer {
+public:
+  static constexpr unsigned int kWorkHistory = 16;  // frames the low-latency prediction looks at
+
+  FramePacer();
+
+  void SetMode(PacingMode mode);
+  inline PacingMode GetMode() const { return mode_; }
+  inline int GetSwapInterval() const { return mode_ == PacingMode::kVsync || mode_ == PacingMode::kLowLatency; }
+
+  // Frame rate of kLimited
+  inline void SetTargetRate(double hz) { target_rate_ = hz; }
+  inline double GetTargetRate() const { return target_rate_; }
+  // Display refresh rate, for kLowLatency
+  inline void SetRefreshRate(double hz) { refresh_rate_ = hz; }
+
+  void WaitForFrameStart();
+  void OnFrameSubmitted();
+  void OnFramePresented();
+
+  // Time from the frame start to the end of SwapBuffers, roughly input to photon for vsynced modes
+  inline double GetLatencyMs() const { return latency_ms_; }
+  inline double GetWaitMs() const { return wait_ms_; }
+
+  // Mode and rate controls with the last frame's wait and latency
+  void OnImGuiRender();
+
+  static const char* GetModeName(PacingMode mode);
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  // Sleeps until shortly before `deadline`, then spins, since sleeps can overshoot by a scheduler tick
+  static void SleepUntil(Clock::time_point deadline);
+
+private:
+  PacingMode mode_;
+  double target_rate_;
+  double refresh_rate_;
+
+  Clock::time_point frame_start_;
+  Clock::time_point next_start_;  // kLimited: start of the next frame, advanced by whole periods
+  Clock::time_point presented_;
+
+  std::array<double, kWorkHistory> work_ms_;  // frame start to OnFrameSubmitted
+  unsigned int work_count_;
+
+  double latency_ms_;
+  double wait_ms_;
+};
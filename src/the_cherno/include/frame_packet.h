@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "glm/glm.hpp"
+#include "render_command_bucket.h"
+
+class VertexBuffer;
+
+// Everything the GL thread needs to draw one frame, recorded by Test::OnExtract without touching GL. The
+// FramePipeline hands a packet to the GL thread once it is recorded and only resets it after the GL thread
+// is done with it, so neither side needs locks while using it.
+class FramePacket {
+public:
+  struct Upload {
+    VertexBuffer* buffer;
+    size_t offset;  // into the packet's upload memory
+    size_t size;
+  };
+
+  FramePacket();
+
+  void Reset();
+
+  // Returns `size` bytes of packet memory that are copied into `buffer` (with SetData) before the draws.
+  // The pointer is only good until the next AllocateUpload
+  void* AllocateUpload(VertexBuffer& buffer, size_t size);
+
+  // A draw whose program is looked up in the ShaderLibrary when the packet is executed, since the library
+  // may only be used on the GL thread. `shader_name` must outlive the packet. Returns nullptr when full
+  DrawPacket* AddDraw(const char* shader_name, uint8_t layer = 0, float depth = 0.0f);
+  inline RenderCommandBucket& GetBucket() { return bucket_; }
+
+  inline void SetClearColor(const glm::vec4& color) { clear_color_ = color; }
+  // Written to the Camera block
+  inline void SetViewProjection(const glm::mat4& view_proj) { view_proj_ = view_proj; }
+
+  inline const glm::vec4& GetClearColor() const { return clear_color_; }
+  inline const glm::mat4& GetViewProjection() const { return view_proj_; }
+  inline const std::vector<Upload>& GetUploads() const { return uploads_; }
+  inline const unsigned char* GetUploadData() const { return upload_data_.get(); }
+  inline const std::vector<std::pair<DrawPacket*, const char*>>& GetNamedDraws() const { return named_draws_; }
+
+private:
+  RenderCommandBucket bucket_;
+  std::vector<std::pair<DrawPacket*, const char*>> named_draws_;
+  // Keeps its capacity across frames, so a steady workload stops allocating after the first frames. Not a
+  // vector, which would zero what it hands out every frame
+  std::unique_ptr<unsigned char[]> upload_data_;
+  size_t upload_size_;
+  size_t upload_capacity_;
+  std::vector<Upload> uploads_;
+  glm::vec4 clear_color_;
+  glm::mat4 view_proj_;
+};
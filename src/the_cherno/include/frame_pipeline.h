@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "frame_clock.h"
+#include "frame_packet.h"
+#include "test.h"
+#include "uniform_buffer.h"
+
+// Drives a test through a frame: fixed steps, OnUpdate, OnInterpolate and then either OnRender or, for
+// tests that use frame packets, OnExtract followed by executing the packet on the GL thread.
+//
+// Threaded, the simulation half of packet tests runs on a simulation thread one frame ahead: while the
+// GL thread executes frame N from one packet, the simulation thread updates the test and extracts frame
+// N+1 into the other, so simulation and driver overhead overlap instead of adding up. Everything else
+// (legacy tests, the menu, UI) stays on the GL thread. Each frame on the GL thread:
+//   pipeline.Sync();                  // the simulation thread is idle from here...
+//   test->OnImGuiRender();            // ...so the UI may touch the test
+//   pipeline.RunFrame(*test, delta);  // starts simulating the next frame and draws the finished one
+class FramePipeline {
+public:
+  FramePipeline();
+  ~FramePipeline();
+
+  // Switching is safe between frames; the packet in flight is still drawn
+  void SetThreaded(bool threaded);
+  inline bool IsThreaded() const { return threaded_; }
+
+  // Waits until the simulation thread is done with the frame it was given
+  void Sync();
+  // GL thread, after Sync
+  void RunFrame(test::Test& test, double delta);
+  // Forgets the finished packet, which refers to the test's GL objects; call after Sync when the test that
+  // recorded it is deleted
+  void Discard();
+
+  // Joins the simulation thread and frees GL resources; must run while the GL context is still alive
+  void Shutdown();
+
+private:
+  void Simulate(test::Test& test, double delta, FramePacket* packet);
+  void Execute(FramePacket& packet);
+  void ThreadLoop();
+  void StopThread();
+
+private:
+  bool threaded_;
+  FixedTimestep timestep_;  // only used by whichever thread is simulating
+  std::array<FramePacket, 2> packets_;
+  FramePacket* ready_;  // recorded by the simulation thread, drawn by the next RunFrame
+  std::unique_ptr<UniformBuffer> camera_;
+
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stopping_;
+  bool busy_;  // the simulation thread owns the job below until it clears this
+  test::Test* job_test_;
+  double job_delta_;
+  FramePacket* job_packet_;
+};
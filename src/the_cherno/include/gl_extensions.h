@@ -0,0 +1,192 @@
+#pragma once
+
+// deps/glad is generated for GL 4.1 core with no extensions. Entry points from later core versions
+// and from extensions are declared and loaded here, using glad's naming so call sites look the same.
+// Each feature flag is set when either the core version or the matching extension is available.
+
+#include "glad/gl.h"
+
+/*──────────────────────────────────────────┐
+│ GL 4.4 / ARB_buffer_storage              │
+└───────────────────────────────────────────*/
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+
+typedef void(GLAD_API_PTR* PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data,
+                                                   GLbitfield flags);
+
+extern int GLAD_GL_ARB_buffer_storage;
+extern PFNGLBUFFERSTORAGEPROC glad_glBufferStorage;
+#define glBufferStorage glad_glBufferStorage
+
+/*──────────────────────────────────────────┐
+│ GL 4.2 / ARB_texture_storage             │
+└───────────────────────────────────────────*/
+#ifndef GL_TEXTURE_IMMUTABLE_FORMAT
+#define GL_TEXTURE_IMMUTABLE_FORMAT 0x912F
+#endif
+
+typedef void(GLAD_API_PTR* PFNGLTEXSTORAGE2DPROC)(GLenum target, GLsizei levels, GLenum internalformat,
+                                                  GLsizei width, GLsizei height);
+typedef void(GLAD_API_PTR* PFNGLTEXSTORAGE3DPROC)(GLenum target, GLsizei levels, GLenum internalformat,
+                                                  GLsizei width, GLsizei height, GLsizei depth);
+
+extern int GLAD_GL_ARB_texture_storage;
+extern PFNGLTEXSTORAGE2DPROC glad_glTexStorage2D;
+extern PFNGLTEXSTORAGE3DPROC glad_glTexStorage3D;
+#define glTexStorage2D glad_glTexStorage2D
+#define glTexStorage3D glad_glTexStorage3D
+
+/*──────────────────────────────────────────┐
+│ GL 4.6 / EXT_texture_filter_anisotropic  │
+└───────────────────────────────────────────*/
+#ifndef GL_TEXTURE_MAX_ANISOTROPY
+#define GL_TEXTURE_MAX_ANISOTROPY 0x84FE
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY 0x84FF
+#endif
+
+extern int GLAD_GL_EXT_texture_filter_anisotropic;
+
+/*──────────────────────────────────────────┐
+│ Compressed texture formats               │
+└───────────────────────────────────────────*/
+// Formats only; glCompressedTexImage2D is core. BC1/BC3 come from EXT_texture_compression_s3tc,
+// BC7 is GL 4.2 / ARB_texture_compression_bptc and ETC2 is GL 4.3 / ARB_ES3_compatibility
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+
+extern int GLAD_GL_EXT_texture_compression_s3tc;
+extern int GLAD_GL_ARB_texture_compression_bptc;
+extern int GLAD_GL_ARB_ES3_compatibility;
+
+/*──────────────────────────────────────────┐
+│ GL 4.3 / KHR_debug                       │
+└───────────────────────────────────────────*/
+#ifndef GL_DEBUG_OUTPUT
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#define GL_DEBUG_SOURCE_API 0x8246
+#define GL_DEBUG_SOURCE_WINDOW_SYSTEM 0x8247
+#define GL_DEBUG_SOURCE_SHADER_COMPILER 0x8248
+#define GL_DEBUG_SOURCE_THIRD_PARTY 0x8249
+#define GL_DEBUG_SOURCE_APPLICATION 0x824A
+#define GL_DEBUG_SOURCE_OTHER 0x824B
+#define GL_DEBUG_TYPE_ERROR 0x824C
+#define GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR 0x824D
+#define GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR 0x824E
+#define GL_DEBUG_TYPE_PORTABILITY 0x824F
+#define GL_DEBUG_TYPE_PERFORMANCE 0x8250
+#define GL_DEBUG_TYPE_OTHER 0x8251
+#define GL_DEBUG_SEVERITY_HIGH 0x9146
+#define GL_DEBUG_SEVERITY_MEDIUM 0x9147
+#define GL_DEBUG_SEVERITY_LOW 0x9148
+#define GL_DEBUG_SEVERITY_NOTIFICATION 0x826B
+#define GL_DEBUG_OUTPUT 0x92E0
+#define GL_CONTEXT_FLAG_DEBUG_BIT 0x00000002
+#endif
+
+typedef void(GLAD_API_PTR* PFNGLDEBUGMESSAGECALLBACKPROC)(GLDEBUGPROC callback, const void* user_param);
+typedef void(GLAD_API_PTR* PFNGLDEBUGMESSAGECONTROLPROC)(GLenum source, GLenum type, GLenum severity,
+                                                         GLsizei count, const GLuint* ids, GLboolean enabled);
+
+extern int GLAD_GL_KHR_debug;
+extern PFNGLDEBUGMESSAGECALLBACKPROC glad_glDebugMessageCallback;
+extern PFNGLDEBUGMESSAGECONTROLPROC glad_glDebugMessageControl;
+#define glDebugMessageCallback glad_glDebugMessageCallback
+#define glDebugMessageControl glad_glDebugMessageControl
+
+/*──────────────────────────────────────────┐
+│ GL 4.1 / ARB_get_program_binary          │
+└───────────────────────────────────────────*/
+// Declared by glad, but only loaded there for 4.1 contexts; loaded here too when the extension is present
+extern int GLAD_GL_ARB_get_program_binary;
+
+/*──────────────────────────────────────────┐
+│ KHR/ARB_parallel_shader_compile          │
+└───────────────────────────────────────────*/
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+typedef void(GLAD_API_PTR* PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+extern int GLAD_GL_KHR_parallel_shader_compile;
+extern PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glad_glMaxShaderCompilerThreadsKHR;
+#define glMaxShaderCompilerThreadsKHR glad_glMaxShaderCompilerThreadsKHR
+
+/*──────────────────────────────────────────┐
+│ ARB_bindless_texture                     │
+└───────────────────────────────────────────*/
+typedef GLuint64(GLAD_API_PTR* PFNGLGETTEXTUREHANDLEARBPROC)(GLuint texture);
+typedef void(GLAD_API_PTR* PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)(GLuint64 handle);
+typedef void(GLAD_API_PTR* PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)(GLuint64 handle);
+
+extern int GLAD_GL_ARB_bindless_texture;
+extern PFNGLGETTEXTUREHANDLEARBPROC glad_glGetTextureHandleARB;
+extern PFNGLMAKETEXTUREHANDLERESIDENTARBPROC glad_glMakeTextureHandleResidentARB;
+extern PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC glad_glMakeTextureHandleNonResidentARB;
+#define glGetTextureHandleARB glad_glGetTextureHandleARB
+#define glMakeTextureHandleResidentARB glad_glMakeTextureHandleResidentARB
+#define glMakeTextureHandleNonResidentARB glad_glMakeTextureHandleNonResidentARB
+
+/*──────────────────────────────────────────┐
+│ NV_gpu_shader5                           │
+└───────────────────────────────────────────*/
+// GLSL only; among other things lets a sampler be picked by an index that differs between invocations
+extern int GLAD_GL_NV_gpu_shader5;
+
+/*──────────────────────────────────────────┐
+│ GL 4.3 / ARB_multi_draw_indirect         │
+└───────────────────────────────────────────*/
+typedef void(GLAD_API_PTR* PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect,
+                                                               GLsizei drawcount, GLsizei stride);
+
+// Also requires GL 4.0 / ARB_draw_indirect for the GL_DRAW_INDIRECT_BUFFER target
+extern int GLAD_GL_ARB_multi_draw_indirect;
+extern PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect;
+#define glMultiDrawElementsIndirect glad_glMultiDrawElementsIndirect
+
+/*──────────────────────────────────────────┐
+│ GL 4.3 / ARB_vertex_attrib_binding       │
+└───────────────────────────────────────────*/
+typedef void(GLAD_API_PTR* PFNGLVERTEXATTRIBFORMATPROC)(GLuint attribindex, GLint size, GLenum type,
+                                                        GLboolean normalized, GLuint relativeoffset);
+typedef void(GLAD_API_PTR* PFNGLVERTEXATTRIBIFORMATPROC)(GLuint attribindex, GLint size, GLenum type,
+                                                         GLuint relativeoffset);
+typedef void(GLAD_API_PTR* PFNGLVERTEXATTRIBBINDINGPROC)(GLuint attribindex, GLuint bindingindex);
+typedef void(GLAD_API_PTR* PFNGLBINDVERTEXBUFFERPROC)(GLuint bindingindex, GLuint buffer, GLintptr offset,
+                                                      GLsizei stride);
+typedef void(GLAD_API_PTR* PFNGLVERTEXBINDINGDIVISORPROC)(GLuint bindingindex, GLuint divisor);
+
+extern int GLAD_GL_ARB_vertex_attrib_binding;
+extern PFNGLVERTEXATTRIBFORMATPROC glad_glVertexAttribFormat;
+extern PFNGLVERTEXATTRIBIFORMATPROC glad_glVertexAttribIFormat;
+extern PFNGLVERTEXATTRIBBINDINGPROC glad_glVertexAttribBinding;
+extern PFNGLBINDVERTEXBUFFERPROC glad_glBindVertexBuffer;
+extern PFNGLVERTEXBINDINGDIVISORPROC glad_glVertexBindingDivisor;
+#define glVertexAttribFormat glad_glVertexAttribFormat
+#define glVertexAttribIFormat glad_glVertexAttribIFormat
+#define glVertexAttribBinding glad_glVertexAttribBinding
+#define glBindVertexBuffer glad_glBindVertexBuffer
+#define glVertexBindingDivisor glad_glVertexBindingDivisor
+
+/*──────────────────────────────────────────┐
+│ Loader                                   │
+└───────────────────────────────────────────*/
+
+// Must be called once after gladLoadGL with a current context
+void LoadGLExtensions(GLADloadfunc load);
+bool HasGLExtension(const char* name);
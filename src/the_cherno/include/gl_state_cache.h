@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <unordered_map>
+
+// Shadows the GL bindings made through it and skips calls that would rebind what is already bound.
+// Everything that binds or deletes programs, VAOs, buffers, textures or samplers must go through here, otherwise
+// the shadow state goes stale; code that touches GL directly can call Invalidate afterwards.
+class GLStateCache {
+public:
+  static constexpr unsigned int kMaxTextureUnits = 32;
+
+  struct Counters {
+    unsigned int issued = 0;
+    unsigned int skipped = 0;
+  };
+
+  static GLStateCache& Get();
+
+  void UseProgram(unsigned int program);
+  void BindVertexArray(unsigned int vao);
+  // Caches GL_ARRAY_BUFFER and GL_ELEMENT_ARRAY_BUFFER, other targets are passed through
+  void BindBuffer(unsigned int target, unsigned int buffer);
+  void ActiveTexture(unsigned int unit);
+  // Caches GL_TEXTURE_2D and GL_TEXTURE_2D_ARRAY, other targets are passed through
+  void BindTexture(unsigned int target, unsigned int unit, unsigned int texture);
+  void BindSampler(unsigned int unit, unsigned int sampler);
+
+  void OnDeleteProgram(unsigned int program);
+  void OnDeleteVertexArray(unsigned int vao);
+  void OnDeleteBuffer(unsigned int buffer);
+  void OnDeleteTexture(unsigned int texture);
+  void OnDeleteSampler(unsigned int sampler);
+
+  void Invalidate();
+
+  // Call once per frame; the counters gathered so far become GetLastFrameCounters
+  void EndFrame();
+  inline const Counters& GetCounters() const { return counters_; }
+  inline const Counters& GetLastFrameCounters() const { return last_frame_counters_; }
+
+private:
+  GLStateCache();
+
+  static int TextureTargetIndex(unsigned int target);
+
+private:
+  static constexpr unsigned int kUnknown = ~0u;
+  static constexpr unsigned int kTextureTargets = 2;
+
+  unsigned int program_;
+  unsigned int vao_;
+  unsigned int array_buffer_;
+  unsigned int element_buffer_;  // the element buffer of vao_, which is VAO state
+  unsigned int active_unit_;
+  std::array<std::array<unsigned int, kTextureTargets>, kMaxTextureUnits> textures_;
+  std::array<unsigned int, kMaxTextureUnits> samplers_;
+
+  // Element buffer each VAO was last seen with, so switching VAOs doesn't forget it
+  std::unordered_map<unsigned int, unsigned int> vao_element_buffers_;
+
+  Counters counters_;
+  Counters last_frame_counters_;
+};
@@ -3,10 +3,13 @@
 class IndexBuffer {
 public:
   IndexBuffer(const unsigned int* data, unsigned int count);
+  // Allocates room for `count` indices to be filled later with SubData
+  explicit IndexBuffer(unsigned int count);
   virtual ~IndexBuffer();
 
   void Bind() const;
   void Unbind() const;
+  void SubData(unsigned int first, const unsigned int* data, unsigned int count);
   unsigned int GetCount() const { return count_; }
 
 private:
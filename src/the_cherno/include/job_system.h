@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class JobCounter;
+
+// A function queued on the JobSystem. Its callable lives in `data`, so queuing a job allocates nothing
+struct alignas(64) Job {
+  static constexpr size_t kDataSize = 40;
+
+  void (*function)(Job& job);
+  JobCounter* counter;
+  alignas(16) unsigned char data[kDataSize];
+  // Cleared while the job is queued or running, so its slot of the owner's ring can't be handed out again
+  std::atomic<bool> free{true};
+};
+
+// Counts the unfinished jobs that were queued with it. A counter must outlive its jobs; Wait returns only
+// once the last of them is completely done with it, so a counter on the waiter's stack is fine
+class JobCounter {
+public:
+  JobCounter() = default;
+  JobCounter(const JobCounter&) = delete;
+  JobCounter& operator=(const JobCounter&) = delete;
+
+  inline bool IsDone() const {
+    return count_.load(std::memory_order_acquire) == 0 && finishing_.load(std::memory_order_acquire) == 0;
+  }
+
+private:
+  friend class JobSystem;
+
+  std::atomic<int> count_{0};
+  // Jobs between their decrement of count_ and their last access to the counter
+  std::atomic<int> finishing_{0};
+  std::mutex mutex_;                 // guards continuations_
+  std::vector<Job*> continuations_;  // queued with RunAfter, released when count_ reaches zero
+};
+
+// Work-stealing job scheduler. Every thread that queues jobs gets its own Chase-Lev deque: the owner pushes
+// and pops at one end without locks, idle threads steal from the other end, so the common case of a
+// thread splitting its own work touches no shared state but its deque. Waiting for a counter runs queued
+// jobs instead of blocking, which also makes nested waits inside jobs safe.
+//
+//   JobCounter counter;
+//   jobs.Run(counter, [&]() { UpdateTransforms(); });
+//   jobs.RunAfter(counter, culled, [&]() { Cull(); });  // starts once the transforms are done
+//   jobs.Wait(culled);
+//
+// Jobs run on any thread, so they must not touch GL; with no workers started the waiting thread runs
+// everything itself.
+class JobSystem {
+public:
+  // Deques: workers plus every other thread that queues jobs
+  static constexpr unsigned int kMaxThreads = 64;
+  // Jobs one thread can have unfinished at a time; past that, Run calls the function on the spot
+  static constexpr unsigned int kJobsPerThread = 4096;
+
+  static JobSystem& Get();
+
+  // Restarts with `workers` worker threads; nothing may be running
+  void Start(unsigned int workers);
+  // Joins the workers; nothing may be running
+  void Shutdown();
+  inline unsigned int GetWorkerCount() const { return worker_count_.load(std::memory_order_relaxed); }
+  // One per hardware thread, less the one that waits
+  static unsigned int GetDefaultWorkerCount();
+
+  template <typename F>
+  void Run(JobCounter& counter, F&& function);
+  // Queues `function` once `dependency` is done; `counter` counts it from now on
+  template <typename F>
+  void RunAfter(JobCounter& dependency, JobCounter& counter, F&& function);
+  // Runs queued jobs, the caller's own first, until `counter` is done
+  void Wait(JobCounter& counter);
+
+  // Calls body(begin, end) over [0, count) in ranges of `grain` items, one of them on the calling thread,
+  // and returns once all are done
+  template <typename F>
+  void ParallelFor(size_t count, size_t grain, F&& body);
+
+  // Worker count slider
+  void OnImGuiRender();
+
+private:
+  JobSystem();
+  ~JobSystem();
+
+  struct Queue;
+
+  template <typename F>
+  Job* CreateJob(JobCounter& counter, F&& function);
+  Job* AllocateJob();
+  void Schedule(Job* job);
+  Job* FindJob(Queue& queue);
+  void Execute(Job& job);
+  Queue& GetQueue();
+  void WorkerLoop();
+
+private:
+  std::mutex mutex_;  // guards queues_ and free_queues_, and pairs with cv_
+  std::array<std::unique_ptr<Queue>, kMaxThreads> queues_;
+  std::atomic<unsigned int> queue_count_;  // queues_ below this are allocated and never change
+  std::vector<unsigned int> free_queues_;  // left behind by exited workers
+
+  std::vector<std::thread> workers_;
+  std::atomic<unsigned int> worker_count_;
+  std::atomic<bool> stopping_;
+  // Bumped by every Schedule; a worker only sleeps while it is unchanged since it last found no work
+  std::atomic<uint64_t> epoch_;
+  std::atomic<unsigned int> sleepers_;
+  std::condition_variable cv_;
+
+  int slider_workers_;  // main thread only, holds the slider's value while it is dragged
+};
+
+template <typename F>
+Job* JobSystem::CreateJob(JobCounter& counter, F&& function) {
+  using Function = std::decay_t<F>;
+  static_assert(sizeof(Function) <= Job::kDataSize, "Job captures too much, capture a pointer to it instead");
+  static_assert(alignof(Function) <= 16, "Job callable is over-aligned");
+
+  // `function` is only moved from when there is a slot for it
+  Job* job = AllocateJob();
+  if (!job) return nullptr;
+  job->counter = &counter;
+  new (job->data) Function(std::forward<F>(function));
+  job->function = [](Job& job) {
+    Function& function = *std::launder(reinterpret_cast<Function*>(job.data));
+    function();
+    function.~Function();
+  };
+  counter.count_.fetch_add(1, std::memory_order_relaxed);
+  return job;
+}
+
+template <typename F>
+void JobSystem::Run(JobCounter& counter, F&& function) {
+  if (Job* job = CreateJob(counter, std::forward<F>(function))) {
+    Schedule(job);
+    return;
+  }
+  // Every slot of this thread's ring is still in use; the caller is far enough ahead to do this one itself
+  function();
+}
+
+template <typename F>
+void JobSystem::RunAfter(JobCounter& dependency, JobCounter& counter, F&& function) {
+  Job* job = CreateJob(counter, std::forward<F>(function));
+  if (!job) {
+    Wait(dependency);
+    function();
+    return;
+  }
+  {
+    // The finishing job takes this lock before it releases the continuations, so the job either lands in
+    // the list in time or sees the dependency already done
+    std::lock_guard<std::mutex> lock(dependency.mutex_);
+    if (dependency.count_.load(std::memory_order_acquire) != 0) {
+      dependency.continuations_.push_back(job);
+      return;
+    }
+  }
+  Schedule(job);
+}
+
+template <typename F>
+void JobSystem::ParallelFor(size_t count, size_t grain, F&& body) {
+  grain = std::max<size_t>(grain, 1);
+  if (count <= grain || GetWorkerCount() == 0) {
+    if (count != 0) body(size_t(0), count);
+    return;
+  }
+
+  JobCounter counter;
+  for (size_t begin = grain; begin < count; begin += grain) {
+    size_t end = std::min(begin + grain, count);
+    Run(counter, [&body, begin, end]() { body(begin, end); });
+  }
+  body(size_t(0), grain);
+  Wait(counter);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "block_compression.h"
+
+// A block compressed image with its mip chain, pointing at blocks stored elsewhere (a mapped KTX file,
+// a CompressedImage). Level 0 is the full image.
+struct CompressedImageView {
+  struct Level {
+    int width, height;
+    const uint8_t* data;
+    size_t size;
+  };
+
+  BlockFormat format;
+  int width, height;
+  std::vector<Level> levels;
+
+  size_t GetSize() const;
+};
+
+// A block compressed image that owns its blocks, stored on disk as KTX 1.1 (one face, no array layers,
+// no key/value data written)
+struct CompressedImage {
+  struct Level {
+    int width, height;
+    std::vector<uint8_t> data;
+  };
+
+  BlockFormat format;
+  int width, height;
+  std::vector<Level> levels;
+
+  size_t GetSize() const;
+  CompressedImageView GetView() const;
+};
+
+bool IsKtxPath(const std::string& path);
+// Points `image` into `bytes`, which must outlive it, without copying the blocks. Returns false, with a
+// message on stdout, when `bytes` isn't a little endian KTX 1.1 file with a format listed in BlockFormat
+bool ParseKtx(const uint8_t* bytes, size_t size, CompressedImageView& image);
+bool WriteKtx(const std::string& path, const CompressedImage& image);
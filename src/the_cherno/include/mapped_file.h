@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A read-only view of a whole file, memory mapped so its bytes are read straight out of the page cache
+// instead of being copied into a heap buffer first. Falls back to reading the file into memory where
+// mapping isn't possible (empty files, unsupported file systems).
+class MappedFile {
+public:
+  MappedFile();
+  explicit MappedFile(const std::string& path);
+  ~MappedFile();
+
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool Open(const std::string& path);
+  void Close();
+
+  inline bool IsOpen() const { return data_ != nullptr; }
+  inline const uint8_t* GetData() const { return data_; }
+  inline size_t GetSize() const { return size_; }
+  inline bool IsMapped() const { return mapping_ != nullptr; }
+
+private:
+  const uint8_t* data_;
+  size_t size_;
+  void* mapping_;  // nullptr when the contents live in fallback_
+  std::vector<uint8_t> fallback_;
+};
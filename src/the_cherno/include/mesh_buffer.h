@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include "index_buffer.h"
+#include "vertex_array.h"
+#include "vertex_buffer.h"
+
+class VertexBufferLayout;
+
+// Where one mesh lives inside a MeshBuffer. Indices stay relative to the mesh's own first vertex,
+// base_vertex moves them to where the mesh was placed
+struct MeshRange {
+  unsigned int first_index = 0;
+  unsigned int index_count = 0;
+  int base_vertex = 0;
+  unsigned int vertex_count = 0;
+
+  inline bool IsValid() const { return index_count != 0; }
+};
+
+// One vertex buffer and one index buffer shared by many meshes of the same vertex layout, so they
+// can all be drawn from a single vertex array, e.g. by one DrawIndirectBuffer submission
+class MeshBuffer {
+public:
+  MeshBuffer(const VertexBufferLayout& layout, unsigned int max_vertices, unsigned int max_indices);
+  virtual ~MeshBuffer();
+
+  // Appends a mesh. Returns an invalid range when either buffer is out of room
+  MeshRange Add(const void* vertices, unsigned int vertex_count, const unsigned int* indices,
+                unsigned int index_count);
+  // Forgets every mesh; ranges handed out before are no longer valid
+  void Clear();
+
+  // Non-const so callers can add per-instance buffers after the shared vertex buffer
+  inline VertexArray& GetVertexArray() { return *vao_; }
+  inline const IndexBuffer& GetIndexBuffer() const { return *index_buffer_; }
+  inline unsigned int GetVertexCount() const { return vertex_count_; }
+  inline unsigned int GetIndexCount() const { return index_count_; }
+
+private:
+  std::unique_ptr<VertexArray> vao_;
+  std::unique_ptr<VertexBuffer> vertex_buffer_;
+  std::unique_ptr<IndexBuffer> index_buffer_;
+  unsigned int stride_;
+  unsigned int max_vertices_, max_indices_;
+  unsigned int vertex_count_, index_count_;
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct MipLevel {
+  int width, height;
+  std::vector<uint8_t> pixels;  // tightly packed RGBA8
+};
+
+inline int GetMipLevelCount(int width, int height) {
+  int levels = 1;
+  while (width > 1 || height > 1) {
+    width = width > 1 ? width / 2 : 1;
+    height = height > 1 ? height / 2 : 1;
+    levels++;
+  }
+  return levels;
+}
+
+// Halves an RGBA8 image with a 2x2 box filter (SSE2 when available). Odd edges reuse the last
+// row/column, dst must hold max(1, w/2) x max(1, h/2) pixels
+void DownsampleBox2x(const uint8_t* src, int width, int height, uint8_t* dst);
+
+// Levels 1..n of the mip chain of an RGBA8 image; level 0 is the image itself and is not included
+std::vector<MipLevel> GenerateMipChain(const uint8_t* pixels, int width, int height);
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+#include "trace_recorder.h"
+
+// Hierarchical per-frame CPU and GPU timings. Scopes nest by the order they open in, and the same scope under
+// the same parent keeps one history across frames. GPU times come from GL_TIMESTAMP queries that are read back
+// kFrameLatency frames later, so resolving them never waits on the GPU.
+// Scopes opened outside BeginFrame/EndFrame, or on any thread but the one calling BeginFrame, are ignored.
+class Profiler {
+public:
+  static constexpr unsigned int kHistory = 240;     // frames of history kept per scope
+  static constexpr unsigned int kFrameLatency = 4;  // frames before a frame's queries are read back
+
+  struct ScopeStats {
+    float min = 0.0f;
+    float avg = 0.0f;
+    float p99 = 0.0f;
+    float last = 0.0f;
+  };
+
+  static Profiler& Get();
+
+  // Opens the root "Frame" scope and reads back the GPU queries of the frame kFrameLatency frames ago
+  void BeginFrame();
+  void EndFrame();
+
+  // `name` must outlive the profiler, use string literals. Returns false when the scope isn't recorded, and
+  // EndScope must not be called for it then
+  bool BeginScope(const char* name, bool gpu);
+  void EndScope();
+
+  // Drops all history, e.g. when switching to another test
+  void Reset();
+  // Frees the query objects, call before the context goes away
+  void Shutdown();
+
+  inline void SetEnabled(bool enabled) { enabled_ = enabled; }
+  inline bool IsEnabled() const { return enabled_; }
+  // False when the driver has no timestamp counter, only CPU times are recorded then
+  inline bool IsGpuSupported() const { return gpu_supported_; }
+
+  // Frame breakdown with min/avg/p99 per scope and a rolling graph of the frame time
+  void OnImGuiRender();
+
+private:
+  Profiler();
+
+  struct History {
+    const char* name;
+    int parent;
+    std::array<float, kHistory> cpu_ms{};
+    std::array<float, kHistory> gpu_ms{};
+    unsigned int cpu_count = 0;  // samples written so far; the newest is at (count - 1) % kHistory
+    unsigned int gpu_count = 0;
+    bool gpu = false;
+    // A scope that opens several times in a frame records the sum of its calls
+    uint64_t frame = ~0ull;
+    float frame_cpu_ms = 0.0f;
+    unsigned int frame_calls = 0;
+    unsigned int calls = 0;  // how often it opened during the last finished frame
+
+    void PushCpu(float ms) { cpu_ms[cpu_count++ % kHistory] = ms; }
+    void PushGpu(float ms) { gpu_ms[gpu_count++ % kHistory] = ms; }
+  };
+
+  struct OpenScope {
+    int history;
+    std::chrono::steady_clock::time_point start;
+    int query;  // index of the begin timestamp in the frame's queries, -1 without GPU timing
+  };
+
+  // Timestamp pairs of one frame in flight
+  struct FrameQueries {
+    std::vector<unsigned int> ids;
+    unsigned int used = 0;
+    std::vector<std::pair<int, int>> scopes;  // history index, begin query index; the end query follows it
+    bool pending = false;
+  };
+
+  int FindHistory(int parent, const char* name);
+  int AllocateQuery();
+  void ResolveQueries(FrameQueries& frame);
+  static ScopeStats ComputeStats(const std::array<float, kHistory>& samples, unsigned int count);
+  void DrawRow(int history);
+
+private:
+  bool enabled_;
+  bool in_frame_;
+  bool gpu_supported_;
+  bool gpu_checked_;
+  uint64_t frame_;
+  unsigned int dropped_frames_;  // frames whose queries were still unavailable after kFrameLatency frames
+
+  std::vector<History> histories_;
+  std::map<std::pair<int, const char*>, int> lookup_;
+  std::vector<OpenScope> stack_;
+  std::vector<int> frame_order_;  // histories in the order they opened in during the last frame
+  std::vector<int> current_order_;
+  std::array<FrameQueries, kFrameLatency> queries_;
+};
+
+// Times the enclosing block on the CPU, and on the GPU for GpuProfileScope. It also shows up in trace captures
+class ProfileScope {
+public:
+  explicit ProfileScope(const char* name, bool gpu = false)
+      : trace_(name), active_(Profiler::Get().BeginScope(name, gpu)) {}
+  ~ProfileScope() {
+    if (active_) Profiler::Get().EndScope();
+  }
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+  TraceScope trace_;
+  bool active_;
+};
+
+class GpuProfileScope : public ProfileScope {
+public:
+  explicit GpuProfileScope(const char* name) : ProfileScope(name, true) {}
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
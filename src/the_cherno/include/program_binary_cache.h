@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+struct ShaderProgramSource;
+
+// On-disk cache of linked program binaries (glGetProgramBinary/glProgramBinary), so a program built
+// once skips GLSL compilation and linking on later runs. Entries are keyed by a hash of the
+// preprocessed sources and the GL vendor, renderer and version strings; a binary the driver rejects
+// (e.g. after a driver update that kept the version string) is treated as a miss.
+class ProgramBinaryCache {
+public:
+  static ProgramBinaryCache& Get();
+
+  // Enabled when the context supports program binaries with at least one format
+  bool IsEnabled();
+  inline void SetDirectory(const std::string& directory) { directory_ = directory; }
+
+  uint64_t MakeKey(const ShaderProgramSource& source);
+
+  // Returns a linked program, or 0 on a miss
+  unsigned int Load(uint64_t key);
+  // `program` must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+  void Store(uint64_t key, unsigned int program);
+
+private:
+  ProgramBinaryCache();
+
+  std::string GetPath(uint64_t key) const;
+
+private:
+  std::string directory_;
+  int enabled_;  // -1 until first queried
+};
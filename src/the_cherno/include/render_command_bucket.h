@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "glm/glm.hpp"
+#include "uniform_handle.h"
+
+class IndexBuffer;
+class Shader;
+class Texture;
+class VertexArray;
+
+// Bump allocator over one fixed block. Allocate may be called from several threads at once;
+// Reset may not overlap with anything else
+class LinearArena {
+public:
+  explicit LinearArena(size_t capacity);
+
+  // Returns nullptr when the arena is full
+  void* Allocate(size_t size, size_t alignment);
+  void Reset();
+
+  inline size_t GetUsed() const { return offset_.load(std::memory_order_relaxed); }
+  inline size_t GetCapacity() const { return capacity_; }
+
+private:
+  std::unique_ptr<unsigned char[]> memory_;
+  size_t capacity_;
+  std::atomic<size_t> offset_;
+};
+
+enum class BlendMode : uint8_t { kOpaque, kAlpha, kAdditive };
+
+struct RecordedUniform {
+  enum class Type : uint8_t { kInt, kFloat, kVec4, kMat4 };
+
+  UniformHandle name;  // runtime names must outlive the Submit
+  Type type;
+  RecordedUniform* next;
+  union {
+    int i;
+    float f;
+    float v[16];
+  } value;
+};
+
+struct DrawPacket {
+  static constexpr unsigned int kMaxTextures = 4;
+
+  Shader* shader = nullptr;
+  const VertexArray* vao = nullptr;
+  const IndexBuffer* ib = nullptr;
+  std::array<const Texture*, kMaxTextures> textures{};  // bound to slots 0..n in order
+  RecordedUniform* uniforms = nullptr;
+  unsigned int instance_count = 1;  // > 1 issues one instanced draw; the vao supplies per-instance data
+  uint8_t layer = 0;
+  float depth = 0.0f;  // [0, 1], sorted front to back within a layer/program/texture
+  bool depth_test = false;
+  BlendMode blend = BlendMode::kOpaque;
+};
+
+// Records draw packets into an arena and replays them sorted by a 64-bit key, so packets that share
+// a program and textures end up next to each other. Packets can be recorded from several threads
+// concurrently; sorting and submission happen on the GL thread through Renderer::Submit.
+//
+// Key layout, most significant first: layer (8) | program (16) | first texture (16) | depth (24).
+// Layers are the only hard ordering, so draws that must happen in a specific order (e.g. translucent
+// after opaque) need their own layer.
+class RenderCommandBucket {
+public:
+  struct Entry {
+    uint64_t key;
+    DrawPacket* packet;
+  };
+
+  explicit RenderCommandBucket(size_t arena_bytes = 1 << 20, unsigned int max_draws = 16384);
+
+  // Returns a default-initialized packet owned by the bucket until Reset, or nullptr if full
+  DrawPacket* AddDraw(uint8_t layer = 0, float depth = 0.0f);
+
+  void SetUniform1i(DrawPacket* packet, UniformHandle name, int value);
+  void SetUniform1f(DrawPacket* packet, UniformHandle name, float value);
+  void SetUniform4f(DrawPacket* packet, UniformHandle name, const glm::vec4& value);
+  void SetUniformMat4f(DrawPacket* packet, UniformHandle name, const glm::mat4& value);
+
+  // Computes the keys and sorts the recorded packets; call after all recording threads are done
+  void Sort();
+  void Reset();
+
+  inline const Entry* begin() const { return entries_.data(); }
+  inline const Entry* end() const { return entries_.data() + GetDrawCount(); }
+  unsigned int GetDrawCount() const;
+
+  static uint64_t MakeKey(const DrawPacket& packet);
+
+private:
+  RecordedUniform* AddUniform(DrawPacket* packet, UniformHandle name, RecordedUniform::Type type);
+
+private:
+  LinearArena arena_;
+  std::vector<Entry> entries_;
+  std::atomic<unsigned int> draw_count_;
+};
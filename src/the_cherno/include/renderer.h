@@ -1,6 +1,7 @@
 #pragma once
 
 #include <alloca.h>
+#include <cstdint>
 #include <iostream>  // IWYU pragma: keep
 #include "glad/gl.h"
 #include "index_buffer.h"
@@ -19,18 +20,122 @@
     DEBUG_BREAK();                             \
   }
 
+// GLCall error checking policies, picked at build time with -DGL_ERROR_POLICY (see CMakeLists.txt)
+#define GL_ERROR_POLICY_NONE 0          // GLCall(x) is just x and the call counter
+#define GL_ERROR_POLICY_SAMPLED 1       // glGetError after every GL_ERROR_SAMPLE_INTERVAL-th call
+#define GL_ERROR_POLICY_CHECK 2         // glGetError before and after every call
+#define GL_ERROR_POLICY_DEBUG_OUTPUT 3  // KHR_debug callback, CHECK until it is enabled or without KHR_debug
+
+#ifndef GL_ERROR_POLICY
+#ifdef NDEBUG
+#define GL_ERROR_POLICY GL_ERROR_POLICY_NONE
+#else
+#define GL_ERROR_POLICY GL_ERROR_POLICY_DEBUG_OUTPUT
+#endif
+#endif
+
+#ifndef GL_ERROR_SAMPLE_INTERVAL
+#define GL_ERROR_SAMPLE_INTERVAL 64
+#endif
+
+// Every GLCall bumps GLCallCount(), which cherno_bench reports per frame. -DGL_CALL_COUNTING=0 compiles it out
+#ifndef GL_CALL_COUNTING
+#define GL_CALL_COUNTING 1
+#endif
+
+#if GL_CALL_COUNTING
+#define GL_COUNT_CALL() (++GLCallCount())
+#else
+#define GL_COUNT_CALL() ((void)0)
+#endif
+
+#if GL_ERROR_POLICY == GL_ERROR_POLICY_NONE
+#define GLCall(x)    \
+  do {               \
+    GL_COUNT_CALL(); \
+    x;               \
+  } while (0);
+#elif GL_ERROR_POLICY == GL_ERROR_POLICY_SAMPLED
+// An error reported here may come from any of the calls since the previous sample
+#define GLCall(x)                                \
+  do {                                           \
+    GL_COUNT_CALL();                             \
+    x;                                           \
+    if (GLShouldSampleError()) {                 \
+      ASSERT(GLLogCall(#x, __FILE__, __LINE__)); \
+    }                                            \
+  } while (0);
+#elif GL_ERROR_POLICY == GL_ERROR_POLICY_CHECK
 #define GLCall(x)                              \
   do {                                         \
+    GL_COUNT_CALL();                           \
     GLClearError();                            \
     x;                                         \
     ASSERT(GLLogCall(#x, __FILE__, __LINE__)); \
   } while (0);
+#elif GL_ERROR_POLICY == GL_ERROR_POLICY_DEBUG_OUTPUT
+#define GLCall(x)                        \
+  do {                                   \
+    GL_COUNT_CALL();                     \
+    GLBeginCall(#x, __FILE__, __LINE__); \
+    x;                                   \
+    ASSERT(GLEndCall());                 \
+  } while (0);
+#else
+#error "Unknown GL_ERROR_POLICY"
+#endif
 
 void GLClearError();
 bool GLLogCall(const char* function, const char* file, int line);
 
+// GL is only called from the thread that owns the context, so the counter is per thread
+inline uint64_t& GLCallCount() {
+  static thread_local uint64_t count = 0;
+  return count;
+}
+
+inline bool GLShouldSampleError() {
+  static thread_local unsigned int calls = 0;
+  return ++calls % GL_ERROR_SAMPLE_INTERVAL == 0;
+}
+
+// Records the call site for the debug message callback. Without debug output, falls back to glGetError
+void GLBeginCall(const char* function, const char* file, int line);
+bool GLEndCall();
+
+// Installs a synchronous KHR_debug callback. Returns false if the context doesn't support it
+bool GLEnableDebugOutput();
+
+class DrawIndirectBuffer;
+class RenderCommandBucket;
+
 class Renderer {
 public:
+  // Totals over every Renderer since the last ResetStats. A multi-draw is one call but several draws
+  struct Stats {
+    uint64_t draw_calls = 0;
+    uint64_t draws = 0;
+  };
+
   void Clear() const;
   void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const;
+  // Draws only the first `index_count` indices of `ib`, offset by `base_vertex` vertices
+  void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int index_count,
+            int base_vertex = 0) const;
+  // Draws `instance_count` copies of the mesh in one call. Per-instance data comes from buffers added with
+  // a layout whose divisor is non-zero, and gl_InstanceID counts the copies in the shader
+  void DrawInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader,
+                     unsigned int instance_count) const;
+  void DrawInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int instance_count,
+                     unsigned int index_count, int base_vertex = 0) const;
+  // Issues every command in `commands` against `va` and `ib`, one glMultiDrawElementsIndirect when the
+  // context has it. Returns the number of GL draw calls that took
+  unsigned int DrawIndirect(const VertexArray& va, const IndexBuffer& ib, const Shader& shader,
+                            DrawIndirectBuffer& commands) const;
+
+  // Sorts the bucket, executes its packets with only the state changes between neighbours, then resets it
+  void Submit(RenderCommandBucket& bucket) const;
+
+  static const Stats& GetStats();
+  static void ResetStats();
 };
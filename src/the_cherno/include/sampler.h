@@ -0,0 +1,43 @@
+#pragma once
+
+enum class TextureFilter {
+  kNearest,
+  kLinear,
+  kTrilinear,  // linear within and between mip levels
+};
+
+enum class TextureWrap { kClamp, kRepeat, kMirror };
+
+// Sampling state kept apart from the texture, so the same texture can be sampled differently by
+// different draws. A sampler bound to a unit overrides the parameters of whatever texture is bound there.
+class Sampler {
+public:
+  Sampler(TextureFilter filter = TextureFilter::kTrilinear, TextureWrap wrap = TextureWrap::kClamp,
+          float anisotropy = 1.0f);
+  ~Sampler();
+
+  Sampler(const Sampler&) = delete;
+  Sampler& operator=(const Sampler&) = delete;
+
+  void Bind(unsigned int unit) const;
+  static void Unbind(unsigned int unit);
+
+  void SetFilter(TextureFilter filter);
+  void SetWrap(TextureWrap wrap);
+  // Clamped to GetMaxAnisotropy(); 1 disables anisotropic filtering
+  void SetAnisotropy(float anisotropy);
+
+  inline TextureFilter GetFilter() const { return filter_; }
+  inline TextureWrap GetWrap() const { return wrap_; }
+  inline float GetAnisotropy() const { return anisotropy_; }
+  inline unsigned int GetRendererID() const { return renderer_id_; }
+
+  // 1 when anisotropic filtering isn't supported
+  static float GetMaxAnisotropy();
+
+private:
+  unsigned int renderer_id_;
+  TextureFilter filter_;
+  TextureWrap wrap_;
+  float anisotropy_;
+};
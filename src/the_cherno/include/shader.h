@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
-#include <unordered_map>
+#include <vector>
 #include "glm/fwd.hpp"
+#include "uniform_buffer.h"
+#include "uniform_handle.h"
 
 struct ShaderProgramSource {
   std::string VertexSource;
@@ -11,25 +14,66 @@ struct ShaderProgramSource {
 
 class Shader {
 public:
-  Shader(const std::string& filepath);
+  enum class CompileMode {
+    kBlocking,  // compiled and linked before the constructor returns
+    kDeferred,  // submitted to the driver; Poll until it returns true before using the program
+  };
+
+  // `defines` are injected after the #version line of each stage, e.g. {"MAX_LIGHTS 4"}
+  Shader(const std::string& filepath, const std::vector<std::string>& defines = {},
+         CompileMode mode = CompileMode::kBlocking);
   ~Shader();
 
+  // Returns true once the program has finished compiling and linking, successfully or not. With
+  // KHR_parallel_shader_compile this never blocks; without it the first call waits for the driver
+  bool Poll();
+  inline bool IsReady() const { return state_ == State::kReady; }
+  inline bool IsFailed() const { return state_ == State::kFailed; }
+
   void Bind() const;
   void Unbind() const;
 
-  void SetUniform1i(const std::string& name, int value);
-  void SetUniform1f(const std::string& name, float value);
-  void SetUniform4f(const std::string& name, float v0, float v1, float v2, float v3);
-  void SetUniformMat4f(const std::string& name, const glm::mat4& matrix);
+  inline unsigned int GetRendererID() const { return renderer_id_; }
+
+  void SetUniform1i(UniformHandle name, int value);
+  void SetUniform1iv(UniformHandle name, int count, const int* values);
+  void SetUniform1f(UniformHandle name, float value);
+  void SetUniform4f(UniformHandle name, float v0, float v1, float v2, float v3);
+  void SetUniformMat4f(UniformHandle name, const glm::mat4& matrix);
+
+  bool HasUniformBlock(const std::string& block) const;
+  void BindUniformBlock(const std::string& block, unsigned int binding);
+  // Queries the size and member offsets of `block`; empty if the program has no such block
+  UniformBlockLayout GetUniformBlockLayout(const std::string& block) const;
 
 private:
   ShaderProgramSource ParseShader(const std::string& filepath);
+  static std::string InjectDefines(const std::string& source, const std::vector<std::string>& defines);
   unsigned int CompileShader(unsigned int type, const std::string& source);
+  bool CheckCompileStatus(unsigned int id, unsigned int type);
+  // Only submits the work; the status queries that would wait for the compiler happen in Finish
   unsigned int CreateShader(const std::string& vertex_shader, const std::string& fragment_shader);
-  int GetUniformLocation(const std::string& name) const;
+  void Finish();
+  // Fills uniform_locations_ with every active uniform (and array element) of the linked program
+  void BuildUniformLocations();
+  void InsertUniformLocation(uint32_t hash, int location) const;
+  int GetUniformLocation(UniformHandle name) const;
 
 private:
+  enum class State { kPending, kReady, kFailed };
+
+  struct UniformSlot {
+    uint32_t hash;  // 0 = empty
+    int location;
+  };
+
   unsigned int renderer_id_;
   std::string file_path_;
-  mutable std::unordered_map<std::string, int> uniform_location_cache_;
+  State state_;
+  unsigned int pending_vs_, pending_fs_;
+  uint64_t cache_key_;
+  // Open-addressed, linearly probed, power-of-two sized. Names missing from the program are inserted
+  // with location -1 on first use so the warning is printed once
+  mutable std::vector<UniformSlot> uniform_locations_;
+  mutable unsigned int uniform_location_count_;
 };
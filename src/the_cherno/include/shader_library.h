@@ -0,0 +1,48 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "shader.h"
+
+// Owns named programs compiled in the background. Load submits a program without waiting for the
+// driver; Update polls the pending ones once per frame. Until a program is ready, Get returns a
+// flat magenta fallback that takes the Camera block and u_model, so callers keep rendering.
+class ShaderLibrary {
+public:
+  using ReadyCallback = std::function<void(Shader&)>;
+
+  static ShaderLibrary& Get();
+
+  // Loading a name twice keeps the first program. `on_ready` runs (with the program bound) once the
+  // program is ready, immediately if it already is; use it for one-time uniform setup
+  void Load(const std::string& name, const std::string& filepath, const std::vector<std::string>& defines = {},
+            ReadyCallback on_ready = nullptr);
+  void Update();
+
+  bool IsReady(const std::string& name) const;
+  // Programs still compiling
+  size_t GetPendingCount() const;
+  // The named program if it is ready, otherwise the fallback
+  Shader& Get(const std::string& name);
+  Shader& GetFallback();
+
+  // Deletes every program; must run while the GL context is still alive
+  void Clear();
+
+private:
+  ShaderLibrary();
+
+  void NotifyReady(Shader& shader, std::vector<ReadyCallback>& callbacks);
+
+private:
+  struct Entry {
+    std::unique_ptr<Shader> shader;
+    std::vector<ReadyCallback> on_ready;
+  };
+
+  std::unordered_map<std::string, Entry> entries_;
+  std::unique_ptr<Shader> fallback_;
+};
@@ -6,15 +6,30 @@
 #include <utility>
 #include <vector>
 
+class FramePacket;
+
 namespace test {
 class Test {
 public:
   Test() {}
   virtual ~Test() {}
 
+  // Fixed rate simulation; runs zero or more times per frame, before OnUpdate
+  virtual void OnFixedUpdate(float step) {}
+  // Once per frame with the real frame time in seconds
   virtual void OnUpdate(float dt) {}
+  // How far real time is past the last fixed step, in steps; called before OnRender to blend the previous
+  // and the current simulated state
+  virtual void OnInterpolate(float alpha) {}
   virtual void OnRender() {}
   virtual void OnImGuiRender() {}
+
+  // Tests that return true describe their frames in OnExtract instead of drawing in OnRender. The
+  // FramePipeline may then run OnFixedUpdate, OnUpdate, OnInterpolate and OnExtract on its simulation
+  // thread, so those must not touch GL, ImGui or the ShaderLibrary. OnImGuiRender stays on the GL thread
+  // and never overlaps them
+  virtual bool UsesFramePackets() const { return false; }
+  virtual void OnExtract(FramePacket& packet) {}
 };
 
 class TestMenu : public Test {
@@ -30,8 +45,14 @@ public:
     tests_.push_back(std::make_pair(name, []() { return new T(); }));
   }
 
+  using Factory = std::function<Test*()>;
+  inline const std::vector<std::pair<std::string, Factory>>& GetTests() const { return tests_; }
+
 private:
   Test*& current_test_;
-  std::vector<std::pair<std::string, std::function<Test*()>>> tests_;
+  std::vector<std::pair<std::string, Factory>> tests_;
 };
+
+// Registers every test, in menu order. Shared by cherno and cherno_bench
+void RegisterTests(TestMenu& menu);
 }  // namespace test
@@ -1,13 +1,17 @@
 #pragma once
 
-#include "index_buffer.h"
-#include "shader.h"
+#include "batch_renderer_2d.h"
+#include "sampler.h"
 #include "test.h"
+#include "texture.h"
+#include "texture_array.h"
+#include "texture_atlas.h"
+#include "uniform_buffer.h"
 
 #include "glm/glm.hpp"
-#include "vertex_array.h"
 
 #include <memory>
+#include <vector>
 
 namespace test {
 
@@ -21,12 +25,32 @@ public:
   void OnImGuiRender() override;
 
 private:
-  std::unique_ptr<VertexArray> vao_;
-  std::unique_ptr<IndexBuffer> index_buffer_;
-  std::unique_ptr<VertexBuffer> vertex_buffer_;
-  std::unique_ptr<Shader> shader_;
+  // Where the textured cells get their image from
+  enum TileSource { kTileImage, kTileTextures, kTileArray };
+
+  void InsertSprite();
+  void CreateTiles();
+
+private:
+  std::unique_ptr<BatchRenderer2D> batch_renderer_;
+  std::shared_ptr<Texture> texture_;
+  std::unique_ptr<UniformBuffer> camera_;
+  std::unique_ptr<Sampler> sampler_;
+  std::unique_ptr<TextureAtlas> atlas_;
+  std::vector<TextureAtlas::Handle> sprites_;
+  std::vector<std::unique_ptr<Texture>> tiles_;
+  std::unique_ptr<TextureArray> tile_array_;
+  std::vector<BatchRenderer2D::Sprite> quads_;  // the untextured and atlas cells of this frame
 
   glm::mat4 proj_, view_;
   glm::vec3 translation_;
+  int quad_count_;
+  bool textured_;
+  bool use_atlas_;
+  int tile_source_;
+  bool bindless_;
+  bool mipmaps_;
+  float anisotropy_;
+  unsigned int sprite_seed_;
 };
 }  // namespace test
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <memory>
+#include "index_buffer.h"
+#include "test.h"
+#include "texture.h"
+#include "vertex_array.h"
+#include "vertex_buffer.h"
+
+namespace test {
+// Draws a grid of up to kMaxInstances textured quads with a single glDrawElementsInstanced. Each
+// instance carries its own model matrix and tint in a second vertex buffer, built while extracting the
+// frame packet on the job system, so with a simulation thread the matrices are computed off the GL thread
+class TestInstancing : public Test {
+public:
+  TestInstancing();
+  virtual ~TestInstancing();
+
+  void OnFixedUpdate(float step) override;
+  void OnUpdate(float deltaTime) override;
+  void OnInterpolate(float alpha) override;
+  void OnImGuiRender() override;
+
+  bool UsesFramePackets() const override { return true; }
+  void OnExtract(FramePacket& packet) override;
+
+  static constexpr int kMaxInstances = 100000;
+
+private:
+  struct Instance {
+    glm::mat4 model;
+    glm::vec4 color;
+  };
+
+  void BuildInstances(Instance* instances) const;
+
+private:
+  std::unique_ptr<VertexArray> vao_;
+  std::unique_ptr<VertexBuffer> vertex_buffer_;
+  std::unique_ptr<VertexBuffer> instance_buffer_;
+  std::unique_ptr<IndexBuffer> index_buffer_;
+  std::shared_ptr<Texture> texture_;
+
+  glm::mat4 proj_;
+  int instance_count_;
+  bool animate_;
+  bool dirty_;
+  // The spin advances in fixed steps and is drawn in between the last two
+  float previous_angle_;
+  float angle_;
+  float render_angle_;
+};
+}  // namespace test
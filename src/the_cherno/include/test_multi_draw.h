@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+#include "draw_indirect_buffer.h"
+#include "mesh_buffer.h"
+#include "test.h"
+#include "uniform_buffer.h"
+#include "vertex_array.h"
+#include "vertex_buffer.h"
+
+namespace test {
+// A scene of kMeshCount distinct polygons packed into one MeshBuffer and drawn through a
+// DrawIndirectBuffer, which is rebuilt every frame as a renderer with culling would. For comparison the
+// same polygons also live in buffers of their own, drawn one call each through a single shared VertexArray
+class TestMultiDraw : public Test {
+public:
+  TestMultiDraw();
+  virtual ~TestMultiDraw();
+
+  void OnUpdate(float deltaTime) override;
+  void OnRender() override;
+  void OnImGuiRender() override;
+
+  static constexpr int kMeshCount = 4096;
+
+private:
+  std::unique_ptr<MeshBuffer> meshes_;
+  std::unique_ptr<DrawIndirectBuffer> commands_;
+  std::unique_ptr<UniformBuffer> camera_;
+  std::vector<MeshRange> ranges_;
+
+  std::unique_ptr<VertexArray> shared_vao_;
+  std::vector<std::unique_ptr<VertexBuffer>> mesh_vertices_;
+  std::vector<std::unique_ptr<IndexBuffer>> mesh_indices_;
+
+  glm::mat4 proj_;
+  int draw_count_;
+  bool multi_draw_;
+  unsigned int last_calls_;
+};
+}  // namespace test
@@ -2,6 +2,7 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <memory>
 #include "index_buffer.h"
 #include "shader.h"
 #include "test.h"
@@ -15,15 +16,17 @@ public:
   virtual ~TestTexture2D();
 
   void OnUpdate(float deltaTime) override;
-  void OnRender() override;
   void OnImGuiRender() override;
 
+  bool UsesFramePackets() const override { return true; }
+  void OnExtract(FramePacket& packet) override;
+
 private:
   std::unique_ptr<VertexArray> vao_;
   std::unique_ptr<IndexBuffer> index_buffer_;
   std::unique_ptr<VertexBuffer> vertex_buffer_;
-  std::unique_ptr<Shader> shader_;
-  std::unique_ptr<Texture> texture_;
+  std::unique_ptr<VertexBuffer> instance_buffer_;
+  std::shared_ptr<Texture> texture_;
 
   glm::mat4 proj_, view_;
   glm::vec3 translation_a_, translation_b_;
@@ -1,21 +1,73 @@
 #pragma once
 
+#include <cstdint>
+#include "ktx_file.h"
 #include "renderer.h"  // IWYU pragma: keep
 
+// How the levels below level 0 are filled
+enum class MipmapMode {
+  kNone,      // a single level
+  kGenerate,  // glGenerateMipmap after level 0 is uploaded
+  kCpu,       // box-filtered on the CPU, see mipmap.h
+};
+
 class Texture {
 public:
-  Texture(const std::string& path);
+  // .ktx files are uploaded as they are, block compressed with their own mip chain; `mipmaps` only
+  // applies to other images
+  Texture(const std::string& path, MipmapMode mipmaps = MipmapMode::kGenerate);
+  // Creates a texture from tightly packed RGBA8 pixels
+  Texture(int width, int height, const unsigned char* data, MipmapMode mipmaps = MipmapMode::kNone);
+  explicit Texture(const CompressedImage& image);
   ~Texture();
 
   void Bind(unsigned int slot = 0) const;
-  void Unbind();
+  void Unbind(unsigned int slot = 0);
+
+  // Reallocates the texture as `width`x`height` RGBA8 and uploads level 0. While a GL_PIXEL_UNPACK_BUFFER
+  // is bound, `data` is an offset into it. With MipmapMode::kGenerate the other levels are generated
+  // here, with kCpu the caller uploads them through SetLevelData
+  void SetData(int width, int height, const void* data);
+
+  // Recreates the storage for `width`x`height` with every level the mipmap mode needs, contents undefined.
+  // Immutable storage can't be resized, so this gives the texture a new renderer id
+  void Allocate(int width, int height);
+  void SetLevelData(int level, const void* data);
+  void GenerateMipmaps();
+
+  // Like Allocate, for `levels` levels of block compressed data filled by SetCompressedLevelData
+  void AllocateCompressed(BlockFormat format, int width, int height, int levels);
+  // `data` is `size` bytes, or an offset into the bound GL_PIXEL_UNPACK_BUFFER
+  void SetCompressedLevelData(int level, const void* data, size_t size);
+  void SetCompressedData(const CompressedImageView& image);
+
+  static bool IsFormatSupported(BlockFormat format);
+
+  // Resident ARB_bindless_texture handle, created on first use; 0 without the extension. Once a handle
+  // exists the texture's parameters are frozen and samplers bound to units don't apply to it
+  uint64_t GetBindlessHandle() const;
 
   inline int GetWidth() const { return width_; }
   inline int GetHeight() const { return height_; }
+  inline int GetLevelCount() const { return levels_; }
+  inline MipmapMode GetMipmapMode() const { return mipmaps_; }
+  inline bool IsCompressed() const { return internal_format_ != GL_RGBA8; }
+  inline unsigned int GetRendererID() const { return renderer_id_; }
+
+private:
+  void Upload(const unsigned char* data);
+  void UploadCompressed(const CompressedImageView& image);
+  void BindForEdit() const;
+  void ReleaseBindlessHandle();
+  void AllocateStorage(unsigned int internal_format, int levels);
 
 private:
   unsigned int renderer_id_;
   std::string file_path_;
   unsigned char* local_buffer_;
   int width_, height_, bpp_;
+  int levels_;
+  MipmapMode mipmaps_;
+  unsigned int internal_format_;
+  mutable uint64_t bindless_handle_;
 };
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include "texture.h"
+
+// Same-sized RGBA8 textures stored as the layers of one GL_TEXTURE_2D_ARRAY, so a shader can pick any of
+// them through a single texture unit. With MipmapMode::kGenerate call GenerateMipmaps once the layers
+// are set; kCpu builds each layer's chain in SetLayer.
+class TextureArray {
+public:
+  TextureArray(int width, int height, unsigned int layers, MipmapMode mipmaps = MipmapMode::kGenerate);
+  ~TextureArray();
+
+  TextureArray(const TextureArray&) = delete;
+  TextureArray& operator=(const TextureArray&) = delete;
+
+  // Tightly packed RGBA8 pixels of the array's size
+  void SetLayer(unsigned int layer, const unsigned char* data);
+  // Returns false if the image can't be loaded or isn't the array's size
+  bool SetLayer(unsigned int layer, const std::string& path);
+  void GenerateMipmaps();
+
+  void Bind(unsigned int slot = 0) const;
+
+  inline int GetWidth() const { return width_; }
+  inline int GetHeight() const { return height_; }
+  inline unsigned int GetLayerCount() const { return layers_; }
+  inline unsigned int GetRendererID() const { return renderer_id_; }
+
+private:
+  void BindForEdit() const;
+
+private:
+  unsigned int renderer_id_;
+  int width_, height_;
+  unsigned int layers_;
+  int levels_;
+  MipmapMode mipmaps_;
+};
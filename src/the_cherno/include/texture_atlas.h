@@ -0,0 +1,71 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "glm/glm.hpp"
+
+// Packs many RGBA8 images into the layers of one GL_TEXTURE_2D_ARRAY, so quads using different images
+// can share a draw call. Fresh space is handed out by a skyline packer (imstb_rectpack.h from imgui);
+// space freed by Remove is reused first, and a layer whose images are all gone starts over empty.
+// Layers are added on demand, doubling up to `max_layers`. Every image gets `padding` pixels of its
+// own edge around it so linear filtering doesn't bleed in from neighbours.
+class TextureAtlas {
+public:
+  using Handle = unsigned int;
+  static constexpr Handle kInvalidHandle = 0;
+
+  struct Region {
+    unsigned int layer;
+    glm::vec2 uv_min, uv_max;
+    int x, y, width, height;  // in texels, without the padding
+  };
+
+  TextureAtlas(int width = 1024, int height = 1024, unsigned int max_layers = 8, int padding = 1);
+  ~TextureAtlas();
+
+  TextureAtlas(const TextureAtlas&) = delete;
+  TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+  // Copies tightly packed RGBA8 pixels into the atlas. Returns kInvalidHandle when the image is larger
+  // than a layer or every layer is full
+  Handle Insert(int width, int height, const unsigned char* data);
+  Handle Insert(const std::string& path);
+  void Remove(Handle handle);
+  void Clear();
+
+  // nullptr once the handle has been removed
+  const Region* GetRegion(Handle handle) const;
+
+  void Bind(unsigned int slot = 0) const;
+
+  inline int GetWidth() const { return width_; }
+  inline int GetHeight() const { return height_; }
+  inline unsigned int GetLayerCount() const { return layer_count_; }
+  inline size_t GetImageCount() const { return regions_.size(); }
+  // Changes when the atlas grows, so look it up again per draw
+  inline unsigned int GetRendererID() const { return renderer_id_; }
+
+private:
+  struct Layer;
+  struct Rect {
+    int x, y, width, height;
+  };
+
+  bool Allocate(int width, int height, unsigned int& layer, Rect& rect);
+  bool AllocateFromFreeList(Layer& layer, int width, int height, Rect& rect);
+  bool Grow();
+  void ResetLayer(Layer& layer);
+
+private:
+  unsigned int renderer_id_;
+  int width_, height_;
+  unsigned int max_layers_;
+  unsigned int layer_count_;
+  int padding_;
+
+  std::vector<std::unique_ptr<Layer>> layers_;
+  std::unordered_map<Handle, Region> regions_;
+  Handle next_handle_;
+};
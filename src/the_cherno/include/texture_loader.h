@@ -0,0 +1,83 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "ktx_file.h"
+#include "mapped_file.h"
+#include "mipmap.h"
+#include "texture.h"
+
+// Loads textures without blocking the render thread. Files are memory mapped and decoded by stb_image on
+// a worker pool; decoded images are uploaded on the GL thread in Update through a pixel unpack buffer,
+// at most GetUploadBudget() bytes per frame. Load returns a usable Texture right away, showing a 1x1
+// grey placeholder until its image has been uploaded. With MipmapMode::kCpu the workers also build
+// the mip chain, and every level goes through the same unpack buffer. Paths ending in .ktx are read
+// as block compressed images (see ktx_file.h) and skip decoding altogether.
+class TextureLoader {
+public:
+  static TextureLoader& Get();
+
+  // Loading a path that is still alive returns the same texture, whatever `mipmaps` asks for
+  std::shared_ptr<Texture> Load(const std::string& path, MipmapMode mipmaps = MipmapMode::kCpu);
+  // Uploads finished images; call once per frame on the GL thread
+  void Update();
+
+  inline void SetUploadBudget(size_t bytes) { upload_budget_ = bytes; }
+  inline size_t GetUploadBudget() const { return upload_budget_; }
+  inline size_t GetPendingCount() const { return pending_.size(); }
+
+  // Stops the workers and frees GL resources; must run while the GL context is still alive
+  void Shutdown();
+
+private:
+  TextureLoader();
+  ~TextureLoader();
+
+  void StartWorkers();
+  void WorkerLoop();
+  struct Result;
+  void Upload(Texture& texture, const Result& result);
+
+private:
+  struct Job {
+    unsigned int id;
+    std::string path;
+    MipmapMode mipmaps;
+  };
+
+  struct Result {
+    unsigned int id = 0;
+    int width = 0, height = 0;
+    unsigned char* pixels = nullptr;  // stbi_image_free'd after upload, nullptr if decoding failed
+    std::vector<MipLevel> mips;
+    // .ktx files skip decoding; their blocks are copied from the mapped file straight into the unpack
+    // buffer, `image` points into `file`
+    bool compressed = false;
+    CompressedImageView image;
+    MappedFile file;
+
+    bool IsValid() const { return compressed || pixels; }
+    size_t GetSize() const;
+  };
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Job> jobs_;
+  std::deque<Result> results_;
+  bool stopping_;
+
+  // GL thread only
+  unsigned int next_id_;
+  std::unordered_map<unsigned int, std::weak_ptr<Texture>> pending_;
+  std::unordered_map<std::string, std::weak_ptr<Texture>> textures_;
+  unsigned int pbo_;
+  size_t pbo_size_;
+  size_t upload_budget_;
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Records timed events from any thread and writes them as Chrome trace event JSON, which chrome://tracing
+// and ui.perfetto.dev both open. Every thread appends to its own fixed-size buffer with no locks; the only
+// shared state on the recording path is the atomic flag checked when a scope opens, so TRACE_SCOPE costs a
+// load while nothing is being captured. Events past a buffer's capacity are dropped and counted.
+class TraceRecorder {
+public:
+  static constexpr unsigned int kEventsPerThread = 1 << 16;
+
+  static TraceRecorder& Get();
+
+  // Starts a capture, dropping the events of the previous one
+  void Start();
+  void Stop();
+  // Starts a capture that stops after `frames` calls to EndFrame and writes itself to `path`
+  void CaptureFrames(unsigned int frames, const std::string& path);
+  // Call once per frame on the main thread; finishes a CaptureFrames window
+  void EndFrame();
+  // Writes the events of the last capture; returns false if the file can't be written
+  bool Dump(const std::string& path) const;
+
+  inline bool IsRecording() const { return recording_.load(std::memory_order_relaxed); }
+  // Nanoseconds since the recorder was created
+  uint64_t Now() const;
+
+  // Appends a complete event to the calling thread's buffer. `name` must outlive the recorder
+  void Record(const char* name, uint64_t begin_ns, uint64_t end_ns);
+  // Labels the calling thread in the trace; `name` must outlive the recorder
+  void SetThreadName(const char* name);
+  // Hands the calling thread's buffer, events and name included, to the next thread that records, so
+  // threads that come and go (job workers) don't each leave one behind. Call just before the thread exits
+  void ReleaseThreadBuffer();
+
+  // Capture button, window length and the result of the last dump
+  void OnImGuiRender();
+
+private:
+  TraceRecorder();
+
+  struct Event {
+    const char* name;
+    uint64_t begin_ns;
+    uint64_t end_ns;
+  };
+
+  // Written only by its thread. `count` is published with release order after the event is in place, and a
+  // buffer whose `generation` isn't the current capture's holds nothing of it
+  struct ThreadBuffer {
+    std::unique_ptr<Event[]> events;
+    std::atomic<uint32_t> count{0};
+    std::atomic<uint32_t> generation{0};
+    std::atomic<uint32_t> dropped{0};
+    std::atomic<const char*> name{nullptr};
+    unsigned int tid = 0;
+  };
+
+  ThreadBuffer& GetThreadBuffer();
+
+private:
+  std::atomic<bool> recording_;
+  std::atomic<uint32_t> generation_;
+  const std::chrono::steady_clock::time_point epoch_;
+
+  mutable std::mutex mutex_;  // guards buffers_ and free_buffers_, taken once per thread
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+  std::vector<ThreadBuffer*> free_buffers_;  // released by exited threads
+  static thread_local ThreadBuffer* t_buffer_;
+
+  // Main thread only
+  unsigned int frames_left_;
+  int window_frames_;
+  std::string capture_path_;
+  std::string status_;
+};
+
+// Records the enclosing block as one event while a capture is running
+class TraceScope {
+public:
+  explicit TraceScope(const char* name) : name_(name), begin_ns_(0) {
+    TraceRecorder& recorder = TraceRecorder::Get();
+    if (recorder.IsRecording()) begin_ns_ = recorder.Now();
+  }
+  ~TraceScope() {
+    // Events that began before a capture started are left out, even if they end inside it
+    if (begin_ns_ != 0) {
+      TraceRecorder& recorder = TraceRecorder::Get();
+      recorder.Record(name_, begin_ns_, recorder.Now());
+    }
+  }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+  const char* name_;
+  uint64_t begin_ns_;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "glm/fwd.hpp"
+
+// Binding points shared by every shader. Shader binds blocks with these names when it is created
+constexpr unsigned int kCameraBlockBinding = 0;
+constexpr const char* kCameraBlockName = "Camera";
+
+// std140 layout of a uniform block as reported by the driver
+struct UniformBlockLayout {
+  std::string name;
+  unsigned int size = 0;
+  std::unordered_map<std::string, unsigned int> offsets;  // member name -> byte offset
+};
+
+// A uniform buffer bound at a fixed binding point. Members are written into a CPU copy at their
+// reflected offsets and uploaded together with Upload, so a block shared by several shaders costs one
+// upload per change instead of one glUniform* per shader per draw
+class UniformBuffer {
+public:
+  UniformBuffer(const UniformBlockLayout& layout, unsigned int binding);
+  ~UniformBuffer();
+
+  void Bind() const;
+
+  void SetInt(const std::string& member, int value);
+  void SetFloat(const std::string& member, float value);
+  void SetVec4f(const std::string& member, const glm::vec4& value);
+  void SetMat4f(const std::string& member, const glm::mat4& value);
+
+  // Uploads the range written since the last Upload
+  void Upload();
+
+  inline unsigned int GetBinding() const { return binding_; }
+
+private:
+  void Write(const std::string& member, const void* data, unsigned int size);
+
+private:
+  unsigned int renderer_id_;
+  unsigned int binding_;
+  UniformBlockLayout layout_;
+  std::vector<unsigned char> data_;
+  unsigned int dirty_begin_, dirty_end_;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// 32-bit FNV-1a. 0 is remapped because Shader's location table uses it to mark empty slots
+constexpr uint32_t HashUniformName(std::string_view name) {
+  uint32_t hash = 2166136261u;
+  for (char c : name) {
+    hash ^= (uint8_t)c;
+    hash *= 16777619u;
+  }
+  return hash ? hash : 1;
+}
+
+// Identifies a uniform by the hash of its name. String literals convert implicitly and are hashed at
+// compile time, so SetUniform*("u_model", ...) neither allocates nor hashes at runtime
+class UniformHandle {
+public:
+  template <size_t N>
+  consteval UniformHandle(const char (&name)[N]) : hash_(HashUniformName({name, N - 1})), name_(name, N - 1) {}
+
+  // For names only known at runtime; the view is kept for diagnostics and must outlive the handle
+  explicit constexpr UniformHandle(std::string_view name) : hash_(HashUniformName(name)), name_(name) {}
+
+  inline constexpr uint32_t GetHash() const { return hash_; }
+  inline constexpr std::string_view GetName() const { return name_; }
+
+private:
+  uint32_t hash_;
+  std::string_view name_;
+};
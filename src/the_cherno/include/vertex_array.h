@@ -1,19 +1,49 @@
 #pragma once
 
+#include <cstdint>
+#include <vector>
 #include "vertex_buffer.h"
 
+struct VertexBufferElement;
 class VertexBufferLayout;
 
+// Attribute formats and the buffers they read from are kept apart: AddFormat describes a layout once
+// and gives it a binding slot, SetVertexBuffer points that slot at any buffer with the same layout. A single
+// VertexArray per vertex format can then serve every mesh that uses it.
+// With GL 4.3 / ARB_vertex_attrib_binding this maps directly onto glVertexAttribFormat and
+// glBindVertexBuffer. On older contexts the split is emulated: SetVertexBuffer re-specifies the slot's
+// attributes with glVertexAttribPointer, which is more calls but still no VAO rebuild.
 class VertexArray {
 public:
   VertexArray();
   virtual ~VertexArray();
 
+  // Declares the attributes of `layout` and returns the binding slot they read from. Attributes of each
+  // format continue at the location after the previous one's, so a per-vertex format followed by a
+  // per-instance one maps to locations 0..n-1 and n..m-1
+  unsigned int AddFormat(const VertexBufferLayout& layout);
+  // Points binding slot `binding` at `vb`, starting `offset` bytes in. Repeated calls with the same
+  // buffer and offset are skipped
+  void SetVertexBuffer(unsigned int binding, const VertexBuffer& vb, unsigned int offset = 0);
+
+  // AddFormat followed by SetVertexBuffer
   void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
 
   void Bind() const;
   void Unbind() const;
 
+private:
+  struct Binding {
+    std::vector<VertexBufferElement> elements;
+    unsigned int first_attribute;
+    unsigned int stride;
+    unsigned int buffer;
+    unsigned int offset;
+    uint64_t serial;  // of the VertexBuffer `buffer` belongs to, 0 before the first SetVertexBuffer
+  };
+
 private:
   unsigned int renderer_id_;
+  unsigned int next_attribute_;
+  std::vector<Binding> bindings_;
 };
@@ -1,13 +1,59 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+
+enum class BufferUsage {
+  kStatic,   // written once
+  kDynamic,  // rewritten occasionally with SetData/SubData
+  kStream,   // rewritten every frame through Map/Unmap
+};
+
 class VertexBuffer {
 public:
   VertexBuffer(const void* data, unsigned int size);
+  // Allocates `size` bytes to be filled later. For kStream, `size` is the size of one ring region and
+  // kStreamRegions regions are allocated
+  explicit VertexBuffer(unsigned int size, BufferUsage usage = BufferUsage::kDynamic);
   virtual ~VertexBuffer();
 
   void Bind() const;
   void Unbind() const;
 
+  // Orphans the current storage, so the driver never waits for draws still reading the old contents.
+  // Grows the buffer when `size` exceeds its capacity. Not valid for kStream buffers
+  void SetData(const void* data, unsigned int size);
+  void SubData(unsigned int offset, const void* data, unsigned int size);
+
+  // kStream only: reserves `size` bytes in the ring and returns a write pointer. `offset` receives the
+  // byte offset of the reservation, aligned to `alignment` (e.g. the vertex stride, for base-vertex draws).
+  // The write must be finished with Unmap before issuing draws that read it
+  void* Map(unsigned int size, unsigned int alignment, unsigned int& offset);
+  void Unmap();
+
+  inline unsigned int GetSize() const { return size_; }
+  inline unsigned int GetRendererID() const { return renderer_id_; }
+  // Unique for the life of the process, unlike GL names, which are handed out again once deleted
+  inline uint64_t GetSerial() const { return serial_; }
+  inline bool IsPersistentlyMapped() const { return mapped_base_ != nullptr; }
+
+  static constexpr unsigned int kStreamRegions = 3;
+
+private:
+  void AdvanceRegion();
+
 private:
   unsigned renderer_id_;
+  uint64_t serial_;
+  unsigned int size_;
+  BufferUsage usage_;
+
+  // Streaming ring: the buffer is split into kStreamRegions regions, each guarded by a fence that is
+  // placed when the writer leaves it and waited on before the writer comes back to it
+  unsigned int region_size_;
+  unsigned int region_index_;
+  unsigned int head_;
+  void* mapped_base_;
+  bool mapped_;
+  std::array<void*, kStreamRegions> fences_;
 };
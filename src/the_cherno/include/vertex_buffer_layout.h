@@ -1,58 +1,191 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
 #include <vector>
+#include "glm/glm.hpp"
+#include "glm/gtc/packing.hpp"
 #include "renderer.h"
 
+// A 16-bit float, as read by a GL_HALF_FLOAT attribute
+struct Half {
+  uint16_t bits = 0;
+
+  Half() = default;
+  explicit Half(float value) : bits(glm::packHalf1x16(value)) {}
+};
+
+// Three signed 10-bit components and a 2-bit w in one word (GL_INT_2_10_10_10_REV). Push it normalized
+// for normals and tangents at a quarter of the size of a vec4
+struct PackedSnorm10 {
+  uint32_t bits = 0;
+
+  PackedSnorm10() = default;
+  explicit PackedSnorm10(const glm::vec4& value) : bits(glm::packSnorm3x10_1x2(value)) {}
+};
+
+// How the shader sees the stored values
+enum class AttributeMode : uint8_t {
+  kFloat,       // converted to float as they are, 255 reads as 255.0
+  kNormalized,  // unsigned integers map to [0, 1], signed ones to [-1, 1]
+  kInteger,     // kept as int/uint in the shader (glVertexAttribIPointer); integer types only
+};
+
 struct VertexBufferElement {
   unsigned int type;
   unsigned int count;
   unsigned int normalized;
+  unsigned int divisor;  // 0 advances per vertex, n advances once every n instances
+  unsigned int offset;   // bytes from the start of the vertex
+  bool integer;
 
-  static unsigned int GetSizeOfType(unsigned int type) {
+  static constexpr unsigned int GetSizeOfType(unsigned int type) {
     switch (type) {
       case GL_FLOAT:
-        return 4;
+      case GL_INT:
       case GL_UNSIGNED_INT:
+      case GL_INT_2_10_10_10_REV:
+      case GL_UNSIGNED_INT_2_10_10_10_REV:
         return 4;
+      case GL_HALF_FLOAT:
+      case GL_SHORT:
+      case GL_UNSIGNED_SHORT:
+        return 2;
+      case GL_BYTE:
       case GL_UNSIGNED_BYTE:
         return 1;
     }
-    ASSERT(false);
     return 0;
   }
+
+  // Packed types hold all four components in one GetSizeOfType
+  static constexpr bool IsPacked(unsigned int type) {
+    return type == GL_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_2_10_10_10_REV;
+  }
+
+  constexpr unsigned int GetSize() const { return IsPacked(type) ? GetSizeOfType(type) : count * GetSizeOfType(type); }
+};
+
+// GL component type and component count of a C++ attribute type
+template <typename T>
+struct VertexAttributeTraits {
+  static_assert(sizeof(T) == 0, "unsupported vertex attribute type");
 };
 
+#define VERTEX_ATTRIBUTE_TRAITS(T, gl_type, components)                               \
+  template <>                                                                         \
+  struct VertexAttributeTraits<T> {                                                   \
+    static constexpr unsigned int kType = gl_type;                                    \
+    static constexpr unsigned int kCount = components;                                \
+    static constexpr bool kIsFloat = gl_type == GL_FLOAT || gl_type == GL_HALF_FLOAT; \
+  };
+
+VERTEX_ATTRIBUTE_TRAITS(float, GL_FLOAT, 1)
+VERTEX_ATTRIBUTE_TRAITS(Half, GL_HALF_FLOAT, 1)
+VERTEX_ATTRIBUTE_TRAITS(int32_t, GL_INT, 1)
+VERTEX_ATTRIBUTE_TRAITS(uint32_t, GL_UNSIGNED_INT, 1)
+VERTEX_ATTRIBUTE_TRAITS(int16_t, GL_SHORT, 1)
+VERTEX_ATTRIBUTE_TRAITS(uint16_t, GL_UNSIGNED_SHORT, 1)
+VERTEX_ATTRIBUTE_TRAITS(int8_t, GL_BYTE, 1)
+VERTEX_ATTRIBUTE_TRAITS(uint8_t, GL_UNSIGNED_BYTE, 1)
+VERTEX_ATTRIBUTE_TRAITS(PackedSnorm10, GL_INT_2_10_10_10_REV, 4)
+
+#undef VERTEX_ATTRIBUTE_TRAITS
+
+template <glm::length_t L, typename T, glm::qualifier Q>
+struct VertexAttributeTraits<glm::vec<L, T, Q>> {
+  static constexpr unsigned int kType = VertexAttributeTraits<T>::kType;
+  static constexpr unsigned int kCount = L * VertexAttributeTraits<T>::kCount;
+  static constexpr bool kIsFloat = VertexAttributeTraits<T>::kIsFloat;
+};
+
+template <typename T, size_t N>
+struct VertexAttributeTraits<T[N]> {
+  static constexpr unsigned int kType = VertexAttributeTraits<T>::kType;
+  static constexpr unsigned int kCount = N * VertexAttributeTraits<T>::kCount;
+  static constexpr bool kIsFloat = VertexAttributeTraits<T>::kIsFloat;
+};
+
+// One attribute of `count` values of T (a scalar, glm vector, array or packed type) at `offset`
+template <typename T, AttributeMode kMode = AttributeMode::kFloat>
+constexpr VertexBufferElement MakeVertexElement(unsigned int offset, unsigned int count = 1) {
+  using Traits = VertexAttributeTraits<T>;
+  static_assert(!Traits::kIsFloat || kMode == AttributeMode::kFloat,
+                "float attributes can't be normalized or integer");
+  static_assert(!VertexBufferElement::IsPacked(Traits::kType) || kMode != AttributeMode::kInteger,
+                "packed attributes can't be integer");
+  return {Traits::kType, Traits::kCount * count, kMode == AttributeMode::kNormalized, 0, offset,
+          kMode == AttributeMode::kInteger};
+}
+
+// The element for `member` of the vertex struct `Vertex`, with its type, count and offset taken from the
+// declaration. `mode` is one of kFloat, kNormalized or kInteger
+#define VERTEX_ATTRIBUTE(Vertex, member, mode) \
+  MakeVertexElement<decltype(Vertex::member), AttributeMode::mode>((unsigned int)offsetof(Vertex, member))
+
+template <size_t N>
+struct VertexLayout {
+  std::array<VertexBufferElement, N> elements;
+  unsigned int stride;
+};
+
+// Describes a vertex struct at compile time, attributes in location order:
+//   constexpr auto kLayout = MakeVertexLayout<Vertex>(VERTEX_ATTRIBUTE(Vertex, position, kFloat), ...);
+template <typename Vertex, typename... Elements>
+constexpr VertexLayout<sizeof...(Elements)> MakeVertexLayout(const Elements&... elements) {
+  return {{elements...}, (unsigned int)sizeof(Vertex)};
+}
+
 class VertexBufferLayout {
 public:
-  explicit VertexBufferLayout() : stride_(0) {}
+  // Every attribute of a layout shares one divisor, since they all live in the same buffer. Pass 1 for a
+  // buffer that holds one record per instance
+  explicit VertexBufferLayout(unsigned int divisor = 0) : stride_(0), divisor_(divisor) {}
 
-  template <typename T>
-  void Push(unsigned int count) {
-    static_assert(false);
+  template <size_t N>
+  explicit VertexBufferLayout(const VertexLayout<N>& layout, unsigned int divisor = 0)
+      : elements_(layout.elements.begin(), layout.elements.end()), stride_(layout.stride), divisor_(divisor) {
+    for (VertexBufferElement& e : elements_) {
+      e.divisor = divisor_;
+    }
   }
 
-  template <>
-  void Push<float>(unsigned int count) {
-    elements_.push_back({GL_FLOAT, count, GL_FALSE});
-    stride_ += VertexBufferElement::GetSizeOfType(GL_FLOAT) * count;
+  // Appends `count` values of T right after the previous attribute, e.g. Push<float>(3) or Push<glm::vec3>(1).
+  // A glm::mat4 takes four consecutive locations, one vec4 column each
+  template <typename T, AttributeMode kMode = AttributeMode::kFloat>
+  void Push(unsigned int count) {
+    if constexpr (std::is_same_v<T, glm::mat4>) {
+      static_assert(kMode == AttributeMode::kFloat);
+      for (unsigned int i = 0; i < count * 4; i++) {
+        Push<glm::vec4>(1);
+      }
+    } else {
+      ASSERT(!VertexBufferElement::IsPacked(VertexAttributeTraits<T>::kType) || count == 1);
+      VertexBufferElement element = MakeVertexElement<T, kMode>(stride_, count);
+      element.divisor = divisor_;
+      elements_.push_back(element);
+      stride_ += element.GetSize();
+    }
   }
 
-  template <>
-  void Push<unsigned int>(unsigned int count) {
-    elements_.push_back({GL_UNSIGNED_INT, count, GL_FALSE});
-    stride_ += VertexBufferElement::GetSizeOfType(GL_UNSIGNED_INT) * count;
+  template <typename T>
+  void PushNormalized(unsigned int count) {
+    Push<T, AttributeMode::kNormalized>(count);
   }
 
-  template <>
-  void Push<unsigned char>(unsigned int count) {
-    elements_.push_back({GL_UNSIGNED_INT, count, GL_FALSE});
-    stride_ += VertexBufferElement::GetSizeOfType(GL_UNSIGNED_BYTE) * count;
+  template <typename T>
+  void PushInteger(unsigned int count) {
+    Push<T, AttributeMode::kInteger>(count);
   }
 
-  inline const std::vector<VertexBufferElement> GetElements() const { return elements_; }
+  inline const std::vector<VertexBufferElement>& GetElements() const { return elements_; }
   inline unsigned int GetStride() const { return stride_; }
+  inline unsigned int GetDivisor() const { return divisor_; }
 
 private:
   std::vector<VertexBufferElement> elements_;
   unsigned int stride_;
+  unsigned int divisor_;
 };
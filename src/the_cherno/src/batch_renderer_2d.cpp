@@ -0,0 +1,327 @@
+#include "batch_renderer_2d.h"
+#include <algorithm>
+#include <cstring>
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
+#include "glm/gtc/packing.hpp"
+#include "job_system.h"
+#include "profiler.h"
+#include "renderer.h"
+#include "shader_library.h"
+#include "vertex_buffer_layout.h"
+
+// Binding point of the BindlessTextures block in batch_bindless.shader
+static constexpr unsigned int kBindlessBlockBinding = 1;
+
+// Array layers are passed as negative indices, so they never collide with texture slots
+static int ArrayLayerIndex(unsigned int layer) { return -(int)(layer + 1); }
+
+// Sprites per culling job and quads per vertex job. Either is only a few nanoseconds per item, so a job
+// needs thousands of them to be worth queuing
+static constexpr size_t kCullGrain = 4096;
+static constexpr size_t kVertexGrain = 2048;
+
+static void WriteQuad(QuadVertex* v, const glm::vec2& position, const glm::vec2& size, const glm::vec4& color,
+                      int tex_index, const glm::vec2& uv_min = glm::vec2(0.0f),
+                      const glm::vec2& uv_max = glm::vec2(1.0f)) {
+  glm::u8vec4 packed_color = glm::packUnorm<uint8_t>(color);
+  glm::u16vec2 uv0 = glm::packUnorm<uint16_t>(uv_min);
+  glm::u16vec2 uv1 = glm::packUnorm<uint16_t>(uv_max);
+  int16_t index = (int16_t)tex_index;
+
+  v[0] = {{position.x, position.y}, packed_color, {uv0.x, uv0.y}, index};
+  v[1] = {{position.x + size.x, position.y}, packed_color, {uv1.x, uv0.y}, index};
+  v[2] = {{position.x + size.x, position.y + size.y}, packed_color, {uv1.x, uv1.y}, index};
+  v[3] = {{position.x, position.y + size.y}, packed_color, {uv0.x, uv1.y}, index};
+}
+
+static constexpr auto kQuadVertexLayout =
+    MakeVertexLayout<QuadVertex>(VERTEX_ATTRIBUTE(QuadVertex, position, kFloat),
+                                 VERTEX_ATTRIBUTE(QuadVertex, color, kNormalized),
+                                 VERTEX_ATTRIBUTE(QuadVertex, tex_coord, kNormalized),
+                                 VERTEX_ATTRIBUTE(QuadVertex, tex_index, kInteger));
+static_assert(sizeof(QuadVertex) == 20, "QuadVertex picked up padding");
+
+BatchRenderer2D::BatchRenderer2D(unsigned int max_quads)
+    : max_quads_(max_quads),
+      texture_slot_limit_(kMaxTextureSlots),
+      quad_count_(0),
+      texture_slots_{},
+      texture_slot_count_(1),
+      atlas_(nullptr),
+      texture_array_(nullptr),
+      sampler_(nullptr),
+      bindless_(false),
+      bindless_buffer_(0) {
+  vertices_.resize(max_quads_ * 4);
+
+  vao_ = std::make_unique<VertexArray>();
+  vertex_buffer_ = std::make_unique<VertexBuffer>(max_quads_ * 4 * sizeof(QuadVertex), BufferUsage::kStream);
+  vao_->AddBuffer(*vertex_buffer_, VertexBufferLayout(kQuadVertexLayout));
+
+  // Every quad uses the same 0-1-2 2-3-0 pattern, so the index buffer is generated once up front
+  std::vector<unsigned int> indices(max_quads_ * 6);
+  for (unsigned int i = 0, offset = 0; i < indices.size(); i += 6, offset += 4) {
+    indices[i + 0] = offset + 0;
+    indices[i + 1] = offset + 1;
+    indices[i + 2] = offset + 2;
+    indices[i + 3] = offset + 2;
+    indices[i + 4] = offset + 3;
+    indices[i + 5] = offset + 0;
+  }
+  index_buffer_ = std::make_unique<IndexBuffer>(indices.data(), indices.size());
+
+  int max_units = 0;
+  GLCall(glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &max_units));
+  texture_slot_limit_ = std::min<unsigned int>(kMaxTextureSlots, max_units - 1);
+
+  ShaderLibrary::Get().Load("batch", "assets/shaders/batch.shader", {}, [](Shader& shader) {
+    int samplers[kMaxTextureSlots];
+    for (unsigned int i = 0; i < kMaxTextureSlots; i++) samplers[i] = i;
+    shader.SetUniform1iv("u_textures", kMaxTextureSlots, samplers);
+    shader.SetUniform1i("u_array", kArraySlot);
+  });
+  if (IsBindlessSupported()) {
+    ShaderLibrary::Get().Load("batch_bindless", "assets/shaders/batch_bindless.shader", {}, [](Shader& shader) {
+      shader.SetUniform1i("u_array", kArraySlot);
+      shader.BindUniformBlock("BindlessTextures", kBindlessBlockBinding);
+    });
+  }
+
+  // Slot 0 is a 1x1 white texture so untextured quads can share a batch with textured ones
+  const unsigned char white[] = {0xff, 0xff, 0xff, 0xff};
+  white_texture_ = std::make_unique<Texture>(1, 1, white);
+  texture_slots_[0] = white_texture_.get();
+}
+
+BatchRenderer2D::~BatchRenderer2D() {
+  if (bindless_buffer_) {
+    GLCall(glDeleteBuffers(1, &bindless_buffer_));
+    GLStateCache::Get().OnDeleteBuffer(bindless_buffer_);
+  }
+}
+
+Shader& BatchRenderer2D::GetShader() const { return ShaderLibrary::Get().Get(bindless_ ? "batch_bindless" : "batch"); }
+
+// batch_bindless.shader picks the sampler per quad, which needs NV_gpu_shader5 on top of the handles
+bool BatchRenderer2D::IsBindlessSupported() { return GLAD_GL_ARB_bindless_texture && GLAD_GL_NV_gpu_shader5; }
+
+void BatchRenderer2D::SetBindless(bool bindless) {
+  if (bindless == bindless_ || !IsBindlessSupported()) return;
+  Flush();
+  bindless_ = bindless;
+  if (bindless_ && !bindless_buffer_) {
+    GLCall(glGenBuffers(1, &bindless_buffer_));
+    GLStateCache::Get().BindBuffer(GL_UNIFORM_BUFFER, bindless_buffer_);
+    GLCall(glBufferData(GL_UNIFORM_BUFFER, kMaxBindlessTextures * sizeof(uint64_t), nullptr, GL_STREAM_DRAW));
+  }
+  BeginBatch();
+}
+
+void BatchRenderer2D::BeginBatch() {
+  quad_count_ = 0;
+  texture_slot_count_ = 1;
+  atlas_ = nullptr;
+  texture_array_ = nullptr;
+  bindless_handles_.clear();
+  bindless_slots_.clear();
+  if (bindless_) {
+    // Slot 0 stays the white texture, like in the slot path
+    bindless_slots_[white_texture_.get()] = 0;
+    bindless_handles_.push_back(white_texture_->GetBindlessHandle());
+  }
+}
+
+void BatchRenderer2D::EndBatch() { Flush(); }
+
+void BatchRenderer2D::Flush() {
+  if (quad_count_ == 0) return;
+  PROFILE_GPU_SCOPE("Batch flush");
+
+  // Each flush goes to a fresh slice of the streaming ring, so the GPU can still be reading earlier ones
+  unsigned int size = quad_count_ * 4 * sizeof(QuadVertex);
+  unsigned int offset = 0;
+  void* dst = vertex_buffer_->Map(size, sizeof(QuadVertex), offset);
+  memcpy(dst, vertices_.data(), size);
+  vertex_buffer_->Unmap();
+
+  BindTextures();
+
+  Renderer renderer;
+  renderer.Draw(*vao_, *index_buffer_, GetShader(), quad_count_ * 6, offset / sizeof(QuadVertex));
+
+  stats_.draw_calls++;
+  stats_.quad_count += quad_count_;
+  BeginBatch();
+}
+
+void BatchRenderer2D::BindTextures() {
+  if (bindless_) {
+    // Orphaned each flush, the previous batch may still be reading its handles
+    GLStateCache::Get().BindBuffer(GL_UNIFORM_BUFFER, bindless_buffer_);
+    GLCall(glBufferData(GL_UNIFORM_BUFFER, kMaxBindlessTextures * sizeof(uint64_t), nullptr, GL_STREAM_DRAW));
+    GLCall(glBufferSubData(GL_UNIFORM_BUFFER, 0, bindless_handles_.size() * sizeof(uint64_t),
+                           bindless_handles_.data()));
+    GLCall(glBindBufferBase(GL_UNIFORM_BUFFER, kBindlessBlockBinding, bindless_buffer_));
+  } else {
+    for (unsigned int i = 0; i < texture_slot_count_; i++) {
+      texture_slots_[i]->Bind(i);
+      if (sampler_) {
+        sampler_->Bind(i);
+      } else {
+        Sampler::Unbind(i);
+      }
+    }
+  }
+
+  if (atlas_ || texture_array_) {
+    if (atlas_) atlas_->Bind(kArraySlot);
+    if (texture_array_) texture_array_->Bind(kArraySlot);
+    if (sampler_) {
+      sampler_->Bind(kArraySlot);
+    } else {
+      Sampler::Unbind(kArraySlot);
+    }
+  }
+}
+
+void BatchRenderer2D::SubmitQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color) {
+  if (quad_count_ >= max_quads_) Flush();
+  PushQuad(position, size, color, 0);
+}
+
+void BatchRenderer2D::SubmitQuad(const glm::vec2& position, const glm::vec2& size, const Texture& texture,
+                                 const glm::vec4& tint) {
+  if (quad_count_ >= max_quads_) Flush();
+  int tex_index = bindless_ ? AcquireBindlessSlot(texture) : AcquireTextureSlot(texture);
+  PushQuad(position, size, tint, tex_index);
+}
+
+void BatchRenderer2D::SubmitQuad(const glm::vec2& position, const glm::vec2& size, const TextureAtlas& atlas,
+                                 TextureAtlas::Handle image, const glm::vec4& tint) {
+  const TextureAtlas::Region* region = atlas.GetRegion(image);
+  if (!region) return;
+  if (quad_count_ >= max_quads_) Flush();
+  AcquireArray(&atlas, nullptr);
+  PushQuad(position, size, tint, ArrayLayerIndex(region->layer), region->uv_min, region->uv_max);
+}
+
+void BatchRenderer2D::SubmitQuad(const glm::vec2& position, const glm::vec2& size, const TextureArray& array,
+                                 unsigned int layer, const glm::vec4& tint) {
+  if (quad_count_ >= max_quads_) Flush();
+  AcquireArray(nullptr, &array);
+  PushQuad(position, size, tint, ArrayLayerIndex(layer));
+}
+
+void BatchRenderer2D::SubmitQuads(const Sprite* sprites, size_t count, const glm::vec2& view_min,
+                                  const glm::vec2& view_max, const TextureAtlas* atlas) {
+  size_t visible;
+  {
+    PROFILE_SCOPE("Cull sprites");
+    visible = CullSprites(sprites, count, view_min, view_max, atlas, visible_);
+  }
+  stats_.culled_count += count - visible;
+
+  // The visible quads go straight into the batch, as many per flush as fit
+  for (size_t done = 0; done < visible;) {
+    if (quad_count_ >= max_quads_) Flush();
+    if (atlas) AcquireArray(atlas, nullptr);
+    size_t quads = std::min<size_t>(max_quads_ - quad_count_, visible - done);
+    {
+      PROFILE_SCOPE("Write quads");
+      WriteSprites(sprites, &visible_[done], quads, atlas, &vertices_[quad_count_ * 4]);
+    }
+    quad_count_ += quads;
+    done += quads;
+  }
+}
+
+size_t BatchRenderer2D::CullSprites(const Sprite* sprites, size_t count, const glm::vec2& view_min,
+                                    const glm::vec2& view_max, const TextureAtlas* atlas,
+                                    std::vector<uint32_t>& visible) {
+  // Every kCullGrain chunk lists its visible sprites at the start of its own range of `visible` and leaves
+  // the length of the list behind the ranges, then the lists are packed in order. A job may get several
+  // chunks, e.g. all of them when ParallelFor runs inline without workers
+  size_t chunks = (count + kCullGrain - 1) / kCullGrain;
+  visible.resize(count + chunks);
+  JobSystem::Get().ParallelFor(count, kCullGrain, [&](size_t begin, size_t end) {
+    TRACE_SCOPE("Cull job");
+    for (size_t chunk_begin = begin; chunk_begin < end; chunk_begin += kCullGrain) {
+      size_t chunk_end = std::min(chunk_begin + kCullGrain, end);
+      uint32_t* out = &visible[chunk_begin];
+      uint32_t listed = 0;
+      for (size_t i = chunk_begin; i < chunk_end; i++) {
+        const Sprite& sprite = sprites[i];
+        if (sprite.position.x > view_max.x || sprite.position.y > view_max.y ||
+            sprite.position.x + sprite.size.x < view_min.x || sprite.position.y + sprite.size.y < view_min.y) {
+          continue;
+        }
+        if (sprite.image != TextureAtlas::kInvalidHandle && !(atlas && atlas->GetRegion(sprite.image))) continue;
+        out[listed++] = (uint32_t)i;
+      }
+      visible[count + chunk_begin / kCullGrain] = listed;
+    }
+  });
+
+  size_t total = 0;
+  for (size_t chunk = 0; chunk < chunks; chunk++) {
+    uint32_t listed = visible[count + chunk];
+    size_t begin = chunk * kCullGrain;
+    if (total != begin) memmove(&visible[total], &visible[begin], listed * sizeof(uint32_t));
+    total += listed;
+  }
+  return total;
+}
+
+void BatchRenderer2D::WriteSprites(const Sprite* sprites, const uint32_t* indices, size_t count,
+                                   const TextureAtlas* atlas, QuadVertex* vertices) {
+  JobSystem::Get().ParallelFor(count, kVertexGrain, [&](size_t begin, size_t end) {
+    TRACE_SCOPE("Vertex job");
+    for (size_t i = begin; i < end; i++) {
+      const Sprite& sprite = sprites[indices[i]];
+      if (sprite.image == TextureAtlas::kInvalidHandle) {
+        WriteQuad(&vertices[i * 4], sprite.position, sprite.size, sprite.color, 0);
+      } else {
+        // Culling already dropped removed images
+        const TextureAtlas::Region* region = atlas->GetRegion(sprite.image);
+        WriteQuad(&vertices[i * 4], sprite.position, sprite.size, sprite.color, ArrayLayerIndex(region->layer),
+                  region->uv_min, region->uv_max);
+      }
+    }
+  });
+}
+
+void BatchRenderer2D::PushQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color,
+                               int tex_index, const glm::vec2& uv_min, const glm::vec2& uv_max) {
+  WriteQuad(&vertices_[quad_count_ * 4], position, size, color, tex_index, uv_min, uv_max);
+  quad_count_++;
+}
+
+int BatchRenderer2D::AcquireTextureSlot(const Texture& texture) {
+  for (unsigned int i = 0; i < texture_slot_count_; i++) {
+    if (texture_slots_[i] == &texture) return (int)i;
+  }
+
+  if (texture_slot_count_ >= texture_slot_limit_) Flush();
+
+  texture_slots_[texture_slot_count_] = &texture;
+  return (int)texture_slot_count_++;
+}
+
+int BatchRenderer2D::AcquireBindlessSlot(const Texture& texture) {
+  auto it = bindless_slots_.find(&texture);
+  if (it != bindless_slots_.end()) return (int)it->second;
+
+  if (bindless_handles_.size() >= kMaxBindlessTextures) Flush();
+
+  unsigned int slot = bindless_handles_.size();
+  bindless_slots_[&texture] = slot;
+  bindless_handles_.push_back(texture.GetBindlessHandle());
+  return (int)slot;
+}
+
+void BatchRenderer2D::AcquireArray(const TextureAtlas* atlas, const TextureArray* array) {
+  if ((atlas_ || texture_array_) && (atlas_ != atlas || texture_array_ != array)) Flush();
+  atlas_ = atlas;
+  texture_array_ = array;
+}
@@ -0,0 +1,479 @@
+#include "block_compression.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// GL enums, duplicated so this file can be built without GL headers
+constexpr unsigned int kGLRGB = 0x1907;
+constexpr unsigned int kGLRGBA = 0x1908;
+constexpr unsigned int kGLBC1 = 0x83F0;   // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+constexpr unsigned int kGLBC3 = 0x83F3;   // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+constexpr unsigned int kGLBC7 = 0x8E8C;   // GL_COMPRESSED_RGBA_BPTC_UNORM
+constexpr unsigned int kGLETC2 = 0x9274;  // GL_COMPRESSED_RGB8_ETC2
+constexpr unsigned int kGLETC2A = 0x9278; // GL_COMPRESSED_RGBA8_ETC2_EAC
+
+struct Block {
+  uint8_t px[16][4];  // row-major, RGBA
+};
+
+inline int Square(int v) { return v * v; }
+
+int ColorError(const uint8_t* a, const uint8_t* b) {
+  return Square(a[0] - b[0]) + Square(a[1] - b[1]) + Square(a[2] - b[2]);
+}
+
+int ColorErrorRGBA(const uint8_t* a, const uint8_t* b) { return ColorError(a, b) + Square(a[3] - b[3]); }
+
+void WriteLE(uint8_t* dst, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) dst[i] = (uint8_t)(value >> (8 * i));
+}
+
+void WriteBE(uint8_t* dst, uint64_t value) {
+  for (int i = 0; i < 8; i++) dst[i] = (uint8_t)(value >> (56 - 8 * i));
+}
+
+// Endpoints of the block's principal axis in `channels` dimensions: the pixels with the smallest and
+// largest projection on it
+void FindPrincipalEndpoints(const Block& block, int channels, float lo[4], float hi[4]) {
+  float mean[4] = {};
+  for (const auto& p : block.px) {
+    for (int c = 0; c < channels; c++) mean[c] += p[c] / 16.0f;
+  }
+  float cov[4][4] = {};
+  for (const auto& p : block.px) {
+    for (int i = 0; i < channels; i++) {
+      for (int j = 0; j < channels; j++) cov[i][j] += (p[i] - mean[i]) * (p[j] - mean[j]);
+    }
+  }
+
+  // A few power iterations are plenty for 16 points
+  float axis[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+  for (int it = 0; it < 8; it++) {
+    float next[4] = {};
+    float length = 0.0f;
+    for (int i = 0; i < channels; i++) {
+      for (int j = 0; j < channels; j++) next[i] += cov[i][j] * axis[j];
+      length = std::max(length, std::fabs(next[i]));
+    }
+    if (length < 1e-6f) break;
+    for (int i = 0; i < channels; i++) axis[i] = next[i] / length;
+  }
+
+  float min_t = std::numeric_limits<float>::max(), max_t = -min_t;
+  for (const auto& p : block.px) {
+    float t = 0.0f;
+    for (int c = 0; c < channels; c++) t += (p[c] - mean[c]) * axis[c];
+    if (t < min_t) {
+      min_t = t;
+      for (int c = 0; c < channels; c++) lo[c] = p[c];
+    }
+    if (t > max_t) {
+      max_t = t;
+      for (int c = 0; c < channels; c++) hi[c] = p[c];
+    }
+  }
+}
+
+/*──────────────────────────────────────────┐
+│ BC1 / BC3                                │
+└───────────────────────────────────────────*/
+uint16_t To565(const float c[3]) {
+  int r = std::clamp((int)std::lround(c[0] * 31.0f / 255.0f), 0, 31);
+  int g = std::clamp((int)std::lround(c[1] * 63.0f / 255.0f), 0, 63);
+  int b = std::clamp((int)std::lround(c[2] * 31.0f / 255.0f), 0, 31);
+  return (uint16_t)(r << 11 | g << 5 | b);
+}
+
+void From565(uint16_t c, uint8_t out[4]) {
+  int r = c >> 11 & 31, g = c >> 5 & 63, b = c & 31;
+  out[0] = (uint8_t)(r << 3 | r >> 2);
+  out[1] = (uint8_t)(g << 2 | g >> 4);
+  out[2] = (uint8_t)(b << 3 | b >> 2);
+  out[3] = 255;
+}
+
+// Always produces a four color block (c0 > c1), which BC3 requires
+void EncodeBC1Color(const Block& block, uint8_t* dst) {
+  float lo[4], hi[4];
+  FindPrincipalEndpoints(block, 3, lo, hi);
+  uint16_t c0 = To565(hi), c1 = To565(lo);
+  if (c0 < c1) std::swap(c0, c1);
+
+  uint32_t indices = 0;
+  if (c0 != c1) {
+    uint8_t palette[4][4];
+    From565(c0, palette[0]);
+    From565(c1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+      palette[2][c] = (uint8_t)((2 * palette[0][c] + palette[1][c]) / 3);
+      palette[3][c] = (uint8_t)((palette[0][c] + 2 * palette[1][c]) / 3);
+    }
+    for (int i = 0; i < 16; i++) {
+      int best = 0, best_error = std::numeric_limits<int>::max();
+      for (int j = 0; j < 4; j++) {
+        int error = ColorError(block.px[i], palette[j]);
+        if (error < best_error) best = j, best_error = error;
+      }
+      indices |= (uint32_t)best << (2 * i);
+    }
+  }
+  WriteLE(dst, c0, 2);
+  WriteLE(dst + 2, c1, 2);
+  WriteLE(dst + 4, indices, 4);
+}
+
+void EncodeBC3Alpha(const Block& block, uint8_t* dst) {
+  int a0 = 0, a1 = 255;
+  for (const auto& p : block.px) {
+    a0 = std::max<int>(a0, p[3]);
+    a1 = std::min<int>(a1, p[3]);
+  }
+
+  uint64_t indices = 0;
+  if (a0 != a1) {
+    // a0 > a1 selects the eight value mode: codes 2-7 interpolate between the endpoints
+    int palette[8] = {a0, a1};
+    for (int i = 1; i <= 6; i++) palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+    for (int i = 0; i < 16; i++) {
+      int best = 0, best_error = 256;
+      for (int j = 0; j < 8; j++) {
+        int error = std::abs(block.px[i][3] - palette[j]);
+        if (error < best_error) best = j, best_error = error;
+      }
+      indices |= (uint64_t)best << (3 * i);
+    }
+  }
+  dst[0] = (uint8_t)a0;
+  dst[1] = (uint8_t)a1;
+  WriteLE(dst + 2, indices, 6);
+}
+
+/*──────────────────────────────────────────┐
+│ BC7 mode 6                               │
+└───────────────────────────────────────────*/
+// One RGBA subset with 7 bit endpoints, a p-bit per endpoint and 4 bit indices
+constexpr int kBC7Weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+struct BitWriter {
+  uint64_t bits[2] = {};
+  int position = 0;
+
+  void Write(uint32_t value, int count) {
+    for (int i = 0; i < count; i++, position++) {
+      if (value >> i & 1) bits[position / 64] |= 1ull << (position % 64);
+    }
+  }
+};
+
+// Quantizes an 8 bit RGBA endpoint to 7 bits + a shared p-bit, picking the p-bit with less error
+void QuantizeBC7Endpoint(const float color[4], uint8_t quantized[4], int& pbit) {
+  int best_error = std::numeric_limits<int>::max();
+  for (int p = 0; p < 2; p++) {
+    uint8_t q[4];
+    int error = 0;
+    for (int c = 0; c < 4; c++) {
+      q[c] = (uint8_t)std::clamp((int)std::lround((color[c] - p) / 2.0f), 0, 127);
+      error += Square((q[c] << 1 | p) - (int)std::lround(color[c]));
+    }
+    if (error < best_error) {
+      best_error = error;
+      pbit = p;
+      memcpy(quantized, q, 4);
+    }
+  }
+}
+
+void EncodeBC7(const Block& block, uint8_t* dst) {
+  float lo[4], hi[4];
+  FindPrincipalEndpoints(block, 4, lo, hi);
+  uint8_t e[2][4];
+  int p[2];
+  QuantizeBC7Endpoint(lo, e[0], p[0]);
+  QuantizeBC7Endpoint(hi, e[1], p[1]);
+
+  uint8_t palette[16][4];
+  for (int i = 0; i < 16; i++) {
+    for (int c = 0; c < 4; c++) {
+      int c0 = e[0][c] << 1 | p[0], c1 = e[1][c] << 1 | p[1];
+      palette[i][c] = (uint8_t)(((64 - kBC7Weights[i]) * c0 + kBC7Weights[i] * c1 + 32) >> 6);
+    }
+  }
+  int indices[16];
+  for (int i = 0; i < 16; i++) {
+    int best_error = std::numeric_limits<int>::max();
+    for (int j = 0; j < 16; j++) {
+      int error = ColorErrorRGBA(block.px[i], palette[j]);
+      if (error < best_error) indices[i] = j, best_error = error;
+    }
+  }
+
+  // The anchor index is stored with its top bit implied zero; swapping the endpoints makes that true
+  if (indices[0] & 8) {
+    std::swap(e[0], e[1]);
+    std::swap(p[0], p[1]);
+    for (int& index : indices) index = 15 - index;
+  }
+
+  BitWriter writer;
+  writer.Write(1 << 6, 7);  // mode 6
+  for (int c = 0; c < 4; c++) {
+    writer.Write(e[0][c], 7);
+    writer.Write(e[1][c], 7);
+  }
+  writer.Write(p[0], 1);
+  writer.Write(p[1], 1);
+  writer.Write(indices[0], 3);
+  for (int i = 1; i < 16; i++) writer.Write(indices[i], 4);
+  WriteLE(dst, writer.bits[0], 8);
+  WriteLE(dst + 8, writer.bits[1], 8);
+}
+
+/*──────────────────────────────────────────┐
+│ ETC2                                     │
+└───────────────────────────────────────────*/
+constexpr int kETCModifiers[8][2] = {{2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}};
+
+// Pixel (x, y) of sub-block `half`
+inline int SubBlockPixel(bool flip, int half, int i) {
+  int x = flip ? i % 4 : half * 2 + i % 2;
+  int y = flip ? half * 2 + i / 4 : i / 2;
+  return y * 4 + x;
+}
+
+// Best modifier table for one sub-block around `base`; fills the 2 bit selectors of its pixels
+int FitETCSubBlock(const Block& block, bool flip, int half, const int base[3], int& table, uint8_t selectors[16]) {
+  int best_total = std::numeric_limits<int>::max();
+  for (int t = 0; t < 8; t++) {
+    int total = 0;
+    uint8_t chosen[8];
+    for (int i = 0; i < 8; i++) {
+      const uint8_t* p = block.px[SubBlockPixel(flip, half, i)];
+      int best_error = std::numeric_limits<int>::max();
+      // Selector values: 0 +small, 1 +large, 2 -small, 3 -large
+      for (int s = 0; s < 4; s++) {
+        int modifier = (s & 2 ? -1 : 1) * kETCModifiers[t][s & 1];
+        uint8_t color[3];
+        for (int c = 0; c < 3; c++) color[c] = (uint8_t)std::clamp(base[c] + modifier, 0, 255);
+        int error = ColorError(p, color);
+        if (error < best_error) best_error = error, chosen[i] = (uint8_t)s;
+      }
+      total += best_error;
+    }
+    if (total < best_total) {
+      best_total = total;
+      table = t;
+      for (int i = 0; i < 8; i++) selectors[SubBlockPixel(flip, half, i)] = chosen[i];
+    }
+  }
+  return best_total;
+}
+
+uint64_t EncodeETC2Color(const Block& block) {
+  uint64_t best_bits = 0;
+  int best_error = std::numeric_limits<int>::max();
+
+  for (int flip = 0; flip < 2; flip++) {
+    float average[2][3] = {};
+    for (int half = 0; half < 2; half++) {
+      for (int i = 0; i < 8; i++) {
+        for (int c = 0; c < 3; c++) average[half][c] += block.px[SubBlockPixel(flip, half, i)][c] / 8.0f;
+      }
+    }
+
+    for (int differential = 0; differential < 2; differential++) {
+      int q[2][3], base[2][3];
+      if (differential) {
+        // 5 bit base plus a 3 bit signed delta; a delta that doesn't fit is clamped
+        for (int c = 0; c < 3; c++) {
+          q[0][c] = std::clamp((int)std::lround(average[0][c] * 31.0f / 255.0f), 0, 31);
+          q[1][c] = std::clamp((int)std::lround(average[1][c] * 31.0f / 255.0f), q[0][c] - 4, q[0][c] + 3);
+          q[1][c] = std::clamp(q[1][c], 0, 31);
+          for (int h = 0; h < 2; h++) base[h][c] = q[h][c] << 3 | q[h][c] >> 2;
+        }
+      } else {
+        for (int c = 0; c < 3; c++) {
+          for (int h = 0; h < 2; h++) {
+            q[h][c] = std::clamp((int)std::lround(average[h][c] * 15.0f / 255.0f), 0, 15);
+            base[h][c] = q[h][c] << 4 | q[h][c];
+          }
+        }
+      }
+
+      int table[2] = {};
+      uint8_t selectors[16];
+      int error = FitETCSubBlock(block, flip, 0, base[0], table[0], selectors) +
+                  FitETCSubBlock(block, flip, 1, base[1], table[1], selectors);
+      if (error >= best_error) continue;
+      best_error = error;
+
+      uint64_t bits = 0;
+      for (int c = 0; c < 3; c++) {
+        int shift = 59 - 8 * c;
+        if (differential) {
+          bits |= (uint64_t)q[0][c] << shift;
+          bits |= (uint64_t)((q[1][c] - q[0][c]) & 7) << (shift - 3);
+        } else {
+          bits |= (uint64_t)q[0][c] << (shift + 1);
+          bits |= (uint64_t)q[1][c] << (shift - 3);
+        }
+      }
+      bits |= (uint64_t)table[0] << 37 | (uint64_t)table[1] << 34;
+      bits |= (uint64_t)differential << 33 | (uint64_t)flip << 32;
+      // Selectors are stored column-major, most significant bits in the upper half
+      for (int i = 0; i < 16; i++) {
+        int bit = (i % 4) * 4 + i / 4;
+        bits |= (uint64_t)(selectors[i] >> 1) << (bit + 16);
+        bits |= (uint64_t)(selectors[i] & 1) << bit;
+      }
+      best_bits = bits;
+    }
+  }
+  return best_bits;
+}
+
+constexpr int kEACModifiers[16][8] = {
+    {-3, -6, -9, -15, 2, 5, 8, 14}, {-3, -7, -10, -13, 2, 6, 9, 12}, {-2, -5, -8, -13, 1, 4, 7, 12},
+    {-2, -4, -6, -13, 1, 3, 5, 12}, {-3, -6, -8, -12, 2, 5, 7, 11},  {-3, -7, -9, -11, 2, 6, 8, 10},
+    {-4, -7, -8, -11, 3, 6, 7, 10}, {-3, -5, -8, -11, 2, 4, 7, 10},  {-2, -6, -8, -10, 1, 5, 7, 9},
+    {-2, -5, -8, -10, 1, 4, 7, 9},  {-2, -4, -8, -10, 1, 3, 7, 9},   {-2, -5, -7, -10, 1, 4, 6, 9},
+    {-3, -4, -7, -10, 2, 3, 6, 9},  {-1, -2, -3, -10, 0, 1, 2, 9},   {-4, -6, -8, -9, 3, 5, 7, 8},
+    {-3, -5, -7, -9, 2, 4, 6, 8}};
+
+uint64_t EncodeEACAlpha(const Block& block) {
+  int lo = 255, hi = 0;
+  for (const auto& p : block.px) {
+    lo = std::min<int>(lo, p[3]);
+    hi = std::max<int>(hi, p[3]);
+  }
+
+  uint64_t best_bits = 0;
+  int best_error = std::numeric_limits<int>::max();
+  int mid = (lo + hi + 1) / 2;
+  for (int base = std::max(mid - 2, 0); base <= std::min(mid + 2, 255) && best_error > 0; base++) {
+    for (int table = 0; table < 16; table++) {
+      for (int multiplier = 1; multiplier < 16; multiplier++) {
+        int error = 0;
+        uint64_t indices = 0;
+        for (int i = 0; i < 16 && error < best_error; i++) {
+          // Pixels are stored column-major, first pixel in the top bits
+          const uint8_t alpha = block.px[(i % 4) * 4 + i / 4][3];
+          int best = 0, best_pixel_error = std::numeric_limits<int>::max();
+          for (int s = 0; s < 8; s++) {
+            int value = std::clamp(base + kEACModifiers[table][s] * multiplier, 0, 255);
+            int pixel_error = Square(alpha - value);
+            if (pixel_error < best_pixel_error) best = s, best_pixel_error = pixel_error;
+          }
+          error += best_pixel_error;
+          indices |= (uint64_t)best << (45 - 3 * i);
+        }
+        if (error < best_error) {
+          best_error = error;
+          best_bits = (uint64_t)base << 56 | (uint64_t)multiplier << 52 | (uint64_t)table << 48 | indices;
+        }
+      }
+    }
+  }
+  return best_bits;
+}
+
+void EncodeBlock(BlockFormat format, const Block& block, uint8_t* dst) {
+  switch (format) {
+    case BlockFormat::kBC1:
+      EncodeBC1Color(block, dst);
+      break;
+    case BlockFormat::kBC3:
+      EncodeBC3Alpha(block, dst);
+      EncodeBC1Color(block, dst + 8);
+      break;
+    case BlockFormat::kBC7:
+      EncodeBC7(block, dst);
+      break;
+    case BlockFormat::kETC2_RGB:
+      WriteBE(dst, EncodeETC2Color(block));
+      break;
+    case BlockFormat::kETC2_RGBA:
+      WriteBE(dst, EncodeEACAlpha(block));
+      WriteBE(dst + 8, EncodeETC2Color(block));
+      break;
+  }
+}
+
+}  // namespace
+
+size_t GetBlockBytes(BlockFormat format) {
+  return format == BlockFormat::kBC1 || format == BlockFormat::kETC2_RGB ? 8 : 16;
+}
+
+size_t GetCompressedSize(BlockFormat format, int width, int height) {
+  return (size_t)((width + 3) / 4) * ((height + 3) / 4) * GetBlockBytes(format);
+}
+
+unsigned int GetGLInternalFormat(BlockFormat format) {
+  switch (format) {
+    case BlockFormat::kBC1:
+      return kGLBC1;
+    case BlockFormat::kBC3:
+      return kGLBC3;
+    case BlockFormat::kBC7:
+      return kGLBC7;
+    case BlockFormat::kETC2_RGB:
+      return kGLETC2;
+    case BlockFormat::kETC2_RGBA:
+      return kGLETC2A;
+  }
+  return 0;
+}
+
+unsigned int GetGLBaseFormat(BlockFormat format) {
+  return format == BlockFormat::kBC1 || format == BlockFormat::kETC2_RGB ? kGLRGB : kGLRGBA;
+}
+
+bool GetBlockFormat(unsigned int gl_internal_format, BlockFormat& format) {
+  for (BlockFormat f : {BlockFormat::kBC1, BlockFormat::kBC3, BlockFormat::kBC7, BlockFormat::kETC2_RGB,
+                        BlockFormat::kETC2_RGBA}) {
+    if (GetGLInternalFormat(f) == gl_internal_format) {
+      format = f;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* GetBlockFormatName(BlockFormat format) {
+  switch (format) {
+    case BlockFormat::kBC1:
+      return "BC1";
+    case BlockFormat::kBC3:
+      return "BC3";
+    case BlockFormat::kBC7:
+      return "BC7";
+    case BlockFormat::kETC2_RGB:
+      return "ETC2 RGB";
+    case BlockFormat::kETC2_RGBA:
+      return "ETC2 RGBA";
+  }
+  return "unknown";
+}
+
+std::vector<uint8_t> CompressImage(BlockFormat format, const uint8_t* rgba, int width, int height) {
+  std::vector<uint8_t> out(GetCompressedSize(format, width, height));
+  size_t block_bytes = GetBlockBytes(format);
+  uint8_t* dst = out.data();
+
+  for (int by = 0; by < height; by += 4) {
+    for (int bx = 0; bx < width; bx += 4) {
+      Block block;
+      for (int i = 0; i < 16; i++) {
+        int x = std::min(bx + i % 4, width - 1);
+        int y = std::min(by + i / 4, height - 1);
+        memcpy(block.px[i], rgba + ((size_t)y * width + x) * 4, 4);
+      }
+      EncodeBlock(format, block, dst);
+      dst += block_bytes;
+    }
+  }
+  return out;
+}
@@ -0,0 +1,71 @@
+#include "draw_indirect_buffer.h"
+#include <cstdint>
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
+#include "mesh_buffer.h"
+#include "renderer.h"
+
+DrawIndirectBuffer::DrawIndirectBuffer(unsigned int capacity)
+    : instanced_commands_(0), renderer_id_(0), capacity_(capacity), dirty_(false) {
+  commands_.reserve(capacity);
+  if (!IsIndirectSupported()) {
+    counts_.reserve(capacity);
+    index_offsets_.reserve(capacity);
+    base_vertices_.reserve(capacity);
+    return;
+  }
+
+  GLCall(glGenBuffers(1, &renderer_id_));
+  GLStateCache::Get().BindBuffer(GL_DRAW_INDIRECT_BUFFER, renderer_id_);
+  GLCall(glBufferData(GL_DRAW_INDIRECT_BUFFER, capacity_ * sizeof(DrawElementsIndirectCommand), nullptr,
+                      GL_DYNAMIC_DRAW));
+}
+
+DrawIndirectBuffer::~DrawIndirectBuffer() {
+  if (renderer_id_ == 0) return;
+  GLCall(glDeleteBuffers(1, &renderer_id_));
+  GLStateCache::Get().OnDeleteBuffer(renderer_id_);
+}
+
+bool DrawIndirectBuffer::IsIndirectSupported() { return GLAD_GL_ARB_multi_draw_indirect; }
+
+void DrawIndirectBuffer::Add(const DrawElementsIndirectCommand& command) {
+  commands_.push_back(command);
+  dirty_ = true;
+  if (command.instance_count != 1) instanced_commands_++;
+
+  if (renderer_id_ == 0) {
+    counts_.push_back((int)command.count);
+    index_offsets_.push_back((const void*)(uintptr_t)(command.first_index * sizeof(unsigned int)));
+    base_vertices_.push_back(command.base_vertex);
+  }
+}
+
+void DrawIndirectBuffer::Add(const MeshRange& mesh, unsigned int instance_count, unsigned int base_instance) {
+  Add({mesh.index_count, instance_count, mesh.first_index, mesh.base_vertex, base_instance});
+}
+
+void DrawIndirectBuffer::Clear() {
+  commands_.clear();
+  counts_.clear();
+  index_offsets_.clear();
+  base_vertices_.clear();
+  instanced_commands_ = 0;
+  dirty_ = true;
+}
+
+void DrawIndirectBuffer::Bind() {
+  ASSERT(renderer_id_ != 0);
+  GLStateCache::Get().BindBuffer(GL_DRAW_INDIRECT_BUFFER, renderer_id_);
+  if (!dirty_) return;
+
+  // Orphan rather than overwrite, so commands still queued for earlier draws are left alone
+  unsigned int size = (unsigned int)(commands_.size() * sizeof(DrawElementsIndirectCommand));
+  if (commands_.size() > capacity_) {
+    capacity_ = (unsigned int)commands_.capacity();
+  }
+  GLCall(glBufferData(GL_DRAW_INDIRECT_BUFFER, capacity_ * sizeof(DrawElementsIndirectCommand), nullptr,
+                      GL_DYNAMIC_DRAW));
+  GLCall(glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, size, commands_.data()));
+  dirty_ = false;
+}
@@ -0,0 +1,35 @@
+#include "frame_clock.h"
+#include <algorithm>
+#include <cmath>
+
+FrameClock::FrameClock() : start_(Clock::now()), last_(start_), delta_(0.0) {}
+
+double FrameClock::Tick() {
+  Clock::time_point now = Clock::now();
+  delta_ = std::min(std::chrono::duration<double>(now - last_).count(), kMaxDelta);
+  last_ = now;
+  return delta_;
+}
+
+double FrameClock::GetTime() const { return std::chrono::duration<double>(Clock::now() - start_).count(); }
+
+FixedTimestep::FixedTimestep(double step, int max_steps)
+    : step_(step), max_steps_(max_steps), accumulator_(0.0), dropped_steps_(0) {}
+
+int FixedTimestep::Advance(double delta) {
+  accumulator_ += delta;
+  // A frame of exactly one step must not come out as 0.9999 of one
+  int steps = (int)std::floor(accumulator_ / step_ + 1e-6);
+  accumulator_ = std::max(accumulator_ - steps * step_, 0.0);
+  if (steps > max_steps_) {
+    dropped_steps_ += steps - max_steps_;
+    steps = max_steps_;
+  }
+  return steps;
+}
+
+void FixedTimestep::SetStep(double step) {
+  // Keep the same fraction of a step, so the interpolation doesn't jump
+  accumulator_ = accumulator_ / step_ * step;
+  step_ = step;
+}
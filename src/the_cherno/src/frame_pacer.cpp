@@ -0,0 +1,97 @@
+#include "frame_pacer.h"
+#include <algorithm>
+#include <thread>
+#include "imgui.h"
+
+// Sleeps wake up to about a scheduler tick late; the last stretch before a deadline is spun instead
+static constexpr std::chrono::microseconds kSpinMargin(2000);
+// Head room kLowLatency leaves on top of the slowest recent frame
+static constexpr double kLatencyMarginMs = 1.5;
+
+FramePacer::FramePacer()
+    : mode_(PacingMode::kVsync),
+      target_rate_(120.0),
+      refresh_rate_(60.0),
+      frame_start_(Clock::now()),
+      next_start_(frame_start_),
+      presented_(frame_start_),
+      work_ms_{},
+      work_count_(0),
+      latency_ms_(0.0),
+      wait_ms_(0.0) {}
+
+void FramePacer::SetMode(PacingMode mode) {
+  mode_ = mode;
+  next_start_ = Clock::now();
+  work_count_ = 0;
+}
+
+void FramePacer::WaitForFrameStart() {
+  Clock::time_point now = Clock::now();
+  Clock::time_point deadline = now;
+
+  if (mode_ == PacingMode::kLimited) {
+    auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / target_rate_));
+    next_start_ += period;
+    // After a slow frame start over from now, rather than rushing through frames to catch up
+    if (next_start_ < now) next_start_ = now;
+    deadline = next_start_;
+  } else if (mode_ == PacingMode::kLowLatency && work_count_ != 0) {
+    // The previous SwapBuffers returned at about a vblank, the next one is a refresh period later
+    unsigned int n = std::min(work_count_, kWorkHistory);
+    double work_ms = *std::max_element(work_ms_.begin(), work_ms_.begin() + n);
+    double wait_ms = 1000.0 / refresh_rate_ - work_ms - kLatencyMarginMs;
+    auto wait = std::chrono::duration<double, std::milli>(std::max(wait_ms, 0.0));
+    deadline = presented_ + std::chrono::duration_cast<Clock::duration>(wait);
+  }
+
+  if (deadline > now) SleepUntil(deadline);
+  frame_start_ = Clock::now();
+  wait_ms_ = std::chrono::duration<double, std::milli>(frame_start_ - now).count();
+}
+
+void FramePacer::OnFrameSubmitted() {
+  std::chrono::duration<double, std::milli> work = Clock::now() - frame_start_;
+  work_ms_[work_count_++ % kWorkHistory] = work.count();
+}
+
+void FramePacer::OnFramePresented() {
+  presented_ = Clock::now();
+  latency_ms_ = std::chrono::duration<double, std::milli>(presented_ - frame_start_).count();
+}
+
+void FramePacer::SleepUntil(Clock::time_point deadline) {
+  if (deadline - Clock::now() > kSpinMargin) std::this_thread::sleep_until(deadline - kSpinMargin);
+  while (Clock::now() < deadline) std::this_thread::yield();
+}
+
+const char* FramePacer::GetModeName(PacingMode mode) {
+  switch (mode) {
+    case PacingMode::kVsync:
+      return "vsync";
+    case PacingMode::kUncapped:
+      return "uncapped";
+    case PacingMode::kLimited:
+      return "frame limiter";
+    case PacingMode::kLowLatency:
+      return "low latency";
+  }
+  return "";
+}
+
+void FramePacer::OnImGuiRender() {
+  if (!ImGui::CollapsingHeader("Frame pacing")) return;
+
+  if (ImGui::BeginCombo("mode", GetModeName(mode_))) {
+    for (PacingMode mode :
+         {PacingMode::kVsync, PacingMode::kUncapped, PacingMode::kLimited, PacingMode::kLowLatency}) {
+      if (ImGui::Selectable(GetModeName(mode), mode == mode_)) SetMode(mode);
+    }
+    ImGui::EndCombo();
+  }
+  if (mode_ == PacingMode::kLimited) {
+    float rate = (float)target_rate_;
+    if (ImGui::SliderFloat("target fps", &rate, 10.0f, 500.0f, "%.0f")) target_rate_ = rate;
+  }
+  ImGui::Text("Waited %.2f ms, frame start to present %.2f ms", wait_ms_, latency_ms_);
+}
@@ -0,0 +1,34 @@
+#include "frame_packet.h"
+#include <algorithm>
+#include <cstring>
+
+FramePacket::FramePacket()
+    : upload_size_(0), upload_capacity_(0), clear_color_(0.0f, 0.0f, 0.0f, 1.0f), view_proj_(1.0f) {}
+
+void FramePacket::Reset() {
+  bucket_.Reset();
+  named_draws_.clear();
+  upload_size_ = 0;
+  uploads_.clear();
+}
+
+void* FramePacket::AllocateUpload(VertexBuffer& buffer, size_t size) {
+  // Uploads are 16 byte aligned, enough for the glm types that usually fill them
+  size_t offset = (upload_size_ + 15) & ~size_t(15);
+  if (offset + size > upload_capacity_) {
+    size_t capacity = std::max(offset + size, upload_capacity_ * 2);
+    std::unique_ptr<unsigned char[]> data(new unsigned char[capacity]);
+    if (upload_size_ != 0) memcpy(data.get(), upload_data_.get(), upload_size_);
+    upload_data_ = std::move(data);
+    upload_capacity_ = capacity;
+  }
+  upload_size_ = offset + size;
+  uploads_.push_back({&buffer, offset, size});
+  return upload_data_.get() + offset;
+}
+
+DrawPacket* FramePacket::AddDraw(const char* shader_name, uint8_t layer, float depth) {
+  DrawPacket* packet = bucket_.AddDraw(layer, depth);
+  if (packet) named_draws_.emplace_back(packet, shader_name);
+  return packet;
+}
@@ -0,0 +1,151 @@
+#include "frame_pipeline.h"
+#include "profiler.h"
+#include "renderer.h"
+#include "shader_library.h"
+#include "trace_recorder.h"
+#include "vertex_buffer.h"
+
+FramePipeline::FramePipeline()
+    : threaded_(false),
+      ready_(nullptr),
+      stopping_(false),
+      busy_(false),
+      job_test_(nullptr),
+      job_delta_(0.0),
+      job_packet_(nullptr) {}
+
+FramePipeline::~FramePipeline() { StopThread(); }
+
+void FramePipeline::SetThreaded(bool threaded) {
+  Sync();
+  threaded_ = threaded;
+}
+
+void FramePipeline::Sync() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!busy_) return;
+  PROFILE_SCOPE("Wait for simulation");
+  cv_.wait(lock, [this]() { return !busy_; });
+}
+
+void FramePipeline::RunFrame(test::Test& test, double delta) {
+  if (!test.UsesFramePackets()) {
+    Simulate(test, delta, nullptr);
+    test.OnRender();
+    return;
+  }
+
+  // A packet left over from threaded mode goes out first, in both modes
+  FramePacket* finished = ready_;
+  ready_ = nullptr;
+  if (!threaded_) {
+    if (finished) Execute(*finished);
+    FramePacket& packet = finished == &packets_[0] ? packets_[1] : packets_[0];
+    Simulate(test, delta, &packet);
+    Execute(packet);
+    return;
+  }
+
+  if (!thread_.joinable()) thread_ = std::thread(&FramePipeline::ThreadLoop, this);
+  // The other packet was executed last frame (or never), so the simulation thread can have it
+  FramePacket* next = finished == &packets_[0] ? &packets_[1] : &packets_[0];
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    busy_ = true;
+    job_test_ = &test;
+    job_delta_ = delta;
+    job_packet_ = next;
+  }
+  cv_.notify_all();
+  ready_ = next;
+
+  // Nothing to draw on the first threaded frame
+  if (finished) Execute(*finished);
+}
+
+void FramePipeline::Discard() {
+  Sync();
+  ready_ = nullptr;
+}
+
+void FramePipeline::Shutdown() {
+  StopThread();
+  ready_ = nullptr;
+  camera_.reset();
+}
+
+void FramePipeline::StopThread() {
+  if (!thread_.joinable()) return;
+  // Let the frame in flight finish, the test it points at is still alive
+  Sync();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+  stopping_ = false;
+}
+
+void FramePipeline::Simulate(test::Test& test, double delta, FramePacket* packet) {
+  TRACE_SCOPE("Simulate");
+  for (int steps = timestep_.Advance(delta); steps > 0; steps--) {
+    test.OnFixedUpdate((float)timestep_.GetStep());
+  }
+  test.OnUpdate((float)delta);
+  test.OnInterpolate(timestep_.GetAlpha());
+
+  if (packet) {
+    TRACE_SCOPE("Extract");
+    packet->Reset();
+    test.OnExtract(*packet);
+  }
+}
+
+void FramePipeline::Execute(FramePacket& packet) {
+  TRACE_SCOPE("Execute packet");
+  const glm::vec4& clear = packet.GetClearColor();
+  GLCall(glClearColor(clear.r, clear.g, clear.b, clear.a));
+  GLCall(glClear(GL_COLOR_BUFFER_BIT));
+
+  for (const FramePacket::Upload& upload : packet.GetUploads()) {
+    upload.buffer->SetData(packet.GetUploadData() + upload.offset, (unsigned int)upload.size);
+  }
+
+  ShaderLibrary& shaders = ShaderLibrary::Get();
+  for (const auto& [draw, name] : packet.GetNamedDraws()) {
+    draw->shader = &shaders.Get(name);
+  }
+  if (packet.GetNamedDraws().empty()) return;
+
+  // Every shader declares the same Camera block, so whichever comes first can describe its layout
+  if (!camera_) {
+    Shader& shader = *packet.GetNamedDraws().front().first->shader;
+    camera_ = std::make_unique<UniformBuffer>(shader.GetUniformBlockLayout(kCameraBlockName), kCameraBlockBinding);
+  }
+  camera_->SetMat4f("u_view_proj", packet.GetViewProjection());
+  camera_->Upload();
+  camera_->Bind();
+
+  Renderer renderer;
+  renderer.Submit(packet.GetBucket());
+}
+
+void FramePipeline::ThreadLoop() {
+  TraceRecorder::Get().SetThreadName("Simulation");
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait(lock, [this]() { return stopping_ || job_test_; });
+    if (stopping_) return;
+
+    test::Test* test = job_test_;
+    job_test_ = nullptr;
+    lock.unlock();
+    Simulate(*test, job_delta_, job_packet_);
+    lock.lock();
+
+    busy_ = false;
+    cv_.notify_all();
+  }
+}
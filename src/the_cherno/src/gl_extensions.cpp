@@ -0,0 +1,128 @@
+#include "gl_extensions.h"
+#include <string>
+#include <unordered_set>
+
+int GLAD_GL_ARB_buffer_storage = 0;
+PFNGLBUFFERSTORAGEPROC glad_glBufferStorage = nullptr;
+
+int GLAD_GL_ARB_get_program_binary = 0;
+
+int GLAD_GL_KHR_parallel_shader_compile = 0;
+PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glad_glMaxShaderCompilerThreadsKHR = nullptr;
+
+int GLAD_GL_ARB_texture_storage = 0;
+PFNGLTEXSTORAGE2DPROC glad_glTexStorage2D = nullptr;
+PFNGLTEXSTORAGE3DPROC glad_glTexStorage3D = nullptr;
+
+int GLAD_GL_EXT_texture_filter_anisotropic = 0;
+
+int GLAD_GL_EXT_texture_compression_s3tc = 0;
+int GLAD_GL_ARB_texture_compression_bptc = 0;
+int GLAD_GL_ARB_ES3_compatibility = 0;
+
+int GLAD_GL_ARB_bindless_texture = 0;
+PFNGLGETTEXTUREHANDLEARBPROC glad_glGetTextureHandleARB = nullptr;
+PFNGLMAKETEXTUREHANDLERESIDENTARBPROC glad_glMakeTextureHandleResidentARB = nullptr;
+PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC glad_glMakeTextureHandleNonResidentARB = nullptr;
+
+int GLAD_GL_NV_gpu_shader5 = 0;
+
+int GLAD_GL_ARB_multi_draw_indirect = 0;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect = nullptr;
+
+int GLAD_GL_ARB_vertex_attrib_binding = 0;
+PFNGLVERTEXATTRIBFORMATPROC glad_glVertexAttribFormat = nullptr;
+PFNGLVERTEXATTRIBIFORMATPROC glad_glVertexAttribIFormat = nullptr;
+PFNGLVERTEXATTRIBBINDINGPROC glad_glVertexAttribBinding = nullptr;
+PFNGLBINDVERTEXBUFFERPROC glad_glBindVertexBuffer = nullptr;
+PFNGLVERTEXBINDINGDIVISORPROC glad_glVertexBindingDivisor = nullptr;
+
+int GLAD_GL_KHR_debug = 0;
+PFNGLDEBUGMESSAGECALLBACKPROC glad_glDebugMessageCallback = nullptr;
+PFNGLDEBUGMESSAGECONTROLPROC glad_glDebugMessageControl = nullptr;
+
+static std::unordered_set<std::string> s_extensions;
+
+static bool HasVersion(int major, int minor) {
+  GLint context_major = 0, context_minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &context_major);
+  glGetIntegerv(GL_MINOR_VERSION, &context_minor);
+  return context_major > major || (context_major == major && context_minor >= minor);
+}
+
+void LoadGLExtensions(GLADloadfunc load) {
+  s_extensions.clear();
+  GLint count = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+  for (GLint i = 0; i < count; i++) {
+    s_extensions.insert((const char*)glGetStringi(GL_EXTENSIONS, i));
+  }
+
+  // Core and ARB entry points share names, so one load covers both
+  glad_glBufferStorage = (PFNGLBUFFERSTORAGEPROC)load("glBufferStorage");
+  GLAD_GL_ARB_buffer_storage =
+      (HasVersion(4, 4) || HasGLExtension("GL_ARB_buffer_storage")) && glad_glBufferStorage != nullptr;
+
+  if (!GLAD_GL_VERSION_4_1 && HasGLExtension("GL_ARB_get_program_binary")) {
+    glad_glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)load("glGetProgramBinary");
+    glad_glProgramBinary = (PFNGLPROGRAMBINARYPROC)load("glProgramBinary");
+    glad_glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)load("glProgramParameteri");
+  }
+  GLAD_GL_ARB_get_program_binary = glad_glGetProgramBinary != nullptr && glad_glProgramBinary != nullptr &&
+                                   glad_glProgramParameteri != nullptr;
+
+  glad_glTexStorage2D = (PFNGLTEXSTORAGE2DPROC)load("glTexStorage2D");
+  glad_glTexStorage3D = (PFNGLTEXSTORAGE3DPROC)load("glTexStorage3D");
+  GLAD_GL_ARB_texture_storage = (HasVersion(4, 2) || HasGLExtension("GL_ARB_texture_storage")) &&
+                                glad_glTexStorage2D != nullptr && glad_glTexStorage3D != nullptr;
+
+  GLAD_GL_EXT_texture_filter_anisotropic = HasVersion(4, 6) || HasGLExtension("GL_ARB_texture_filter_anisotropic") ||
+                                           HasGLExtension("GL_EXT_texture_filter_anisotropic");
+
+  GLAD_GL_EXT_texture_compression_s3tc = HasGLExtension("GL_EXT_texture_compression_s3tc");
+  GLAD_GL_ARB_texture_compression_bptc = HasVersion(4, 2) || HasGLExtension("GL_ARB_texture_compression_bptc");
+  GLAD_GL_ARB_ES3_compatibility = HasVersion(4, 3) || HasGLExtension("GL_ARB_ES3_compatibility");
+
+  if (HasGLExtension("GL_ARB_bindless_texture")) {
+    glad_glGetTextureHandleARB = (PFNGLGETTEXTUREHANDLEARBPROC)load("glGetTextureHandleARB");
+    glad_glMakeTextureHandleResidentARB = (PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)load("glMakeTextureHandleResidentARB");
+    glad_glMakeTextureHandleNonResidentARB =
+        (PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)load("glMakeTextureHandleNonResidentARB");
+  }
+  GLAD_GL_ARB_bindless_texture = glad_glGetTextureHandleARB != nullptr &&
+                                 glad_glMakeTextureHandleResidentARB != nullptr &&
+                                 glad_glMakeTextureHandleNonResidentARB != nullptr;
+
+  GLAD_GL_NV_gpu_shader5 = HasGLExtension("GL_NV_gpu_shader5");
+
+  glad_glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)load("glMultiDrawElementsIndirect");
+  GLAD_GL_ARB_multi_draw_indirect =
+      (HasVersion(4, 3) || (HasGLExtension("GL_ARB_multi_draw_indirect") &&
+                            (HasVersion(4, 0) || HasGLExtension("GL_ARB_draw_indirect")))) &&
+      glad_glMultiDrawElementsIndirect != nullptr;
+
+  glad_glVertexAttribFormat = (PFNGLVERTEXATTRIBFORMATPROC)load("glVertexAttribFormat");
+  glad_glVertexAttribIFormat = (PFNGLVERTEXATTRIBIFORMATPROC)load("glVertexAttribIFormat");
+  glad_glVertexAttribBinding = (PFNGLVERTEXATTRIBBINDINGPROC)load("glVertexAttribBinding");
+  glad_glBindVertexBuffer = (PFNGLBINDVERTEXBUFFERPROC)load("glBindVertexBuffer");
+  glad_glVertexBindingDivisor = (PFNGLVERTEXBINDINGDIVISORPROC)load("glVertexBindingDivisor");
+  GLAD_GL_ARB_vertex_attrib_binding = (HasVersion(4, 3) || HasGLExtension("GL_ARB_vertex_attrib_binding")) &&
+                                      glad_glVertexAttribFormat != nullptr && glad_glVertexAttribIFormat != nullptr &&
+                                      glad_glVertexAttribBinding != nullptr && glad_glBindVertexBuffer != nullptr &&
+                                      glad_glVertexBindingDivisor != nullptr;
+
+  // The ARB variant has the same enums and signature
+  if (HasGLExtension("GL_KHR_parallel_shader_compile")) {
+    glad_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsKHR");
+  } else if (HasGLExtension("GL_ARB_parallel_shader_compile")) {
+    glad_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsARB");
+  }
+  GLAD_GL_KHR_parallel_shader_compile = glad_glMaxShaderCompilerThreadsKHR != nullptr;
+
+  glad_glDebugMessageCallback = (PFNGLDEBUGMESSAGECALLBACKPROC)load("glDebugMessageCallback");
+  glad_glDebugMessageControl = (PFNGLDEBUGMESSAGECONTROLPROC)load("glDebugMessageControl");
+  GLAD_GL_KHR_debug = (HasVersion(4, 3) || HasGLExtension("GL_KHR_debug")) &&
+                      glad_glDebugMessageCallback != nullptr && glad_glDebugMessageControl != nullptr;
+}
+
+bool HasGLExtension(const char* name) { return s_extensions.count(name) != 0; }
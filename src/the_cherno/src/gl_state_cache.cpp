@@ -0,0 +1,150 @@
+#include "gl_state_cache.h"
+#include "renderer.h"
+
+GLStateCache& GLStateCache::Get() {
+  static GLStateCache cache;
+  return cache;
+}
+
+GLStateCache::GLStateCache() { Invalidate(); }
+
+void GLStateCache::UseProgram(unsigned int program) {
+  if (program_ == program) {
+    counters_.skipped++;
+    return;
+  }
+  GLCall(glUseProgram(program));
+  program_ = program;
+  counters_.issued++;
+}
+
+void GLStateCache::BindVertexArray(unsigned int vao) {
+  if (vao_ == vao) {
+    counters_.skipped++;
+    return;
+  }
+  GLCall(glBindVertexArray(vao));
+  vao_ = vao;
+  auto it = vao_element_buffers_.find(vao);
+  element_buffer_ = it != vao_element_buffers_.end() ? it->second : kUnknown;
+  counters_.issued++;
+}
+
+void GLStateCache::BindBuffer(unsigned int target, unsigned int buffer) {
+  unsigned int* cached = nullptr;
+  if (target == GL_ARRAY_BUFFER) {
+    cached = &array_buffer_;
+  } else if (target == GL_ELEMENT_ARRAY_BUFFER) {
+    cached = &element_buffer_;
+  }
+
+  if (cached && *cached == buffer) {
+    counters_.skipped++;
+    return;
+  }
+  GLCall(glBindBuffer(target, buffer));
+  counters_.issued++;
+  if (!cached) return;
+
+  *cached = buffer;
+  if (target == GL_ELEMENT_ARRAY_BUFFER && vao_ != kUnknown) {
+    vao_element_buffers_[vao_] = buffer;
+  }
+}
+
+void GLStateCache::ActiveTexture(unsigned int unit) {
+  if (active_unit_ == unit) {
+    counters_.skipped++;
+    return;
+  }
+  GLCall(glActiveTexture(GL_TEXTURE0 + unit));
+  active_unit_ = unit;
+  counters_.issued++;
+}
+
+void GLStateCache::BindTexture(unsigned int target, unsigned int unit, unsigned int texture) {
+  int index = TextureTargetIndex(target);
+  if (index >= 0 && unit < kMaxTextureUnits && textures_[unit][index] == texture) {
+    counters_.skipped++;
+    return;
+  }
+  ActiveTexture(unit);
+  GLCall(glBindTexture(target, texture));
+  counters_.issued++;
+  if (index >= 0 && unit < kMaxTextureUnits) {
+    textures_[unit][index] = texture;
+  }
+}
+
+void GLStateCache::BindSampler(unsigned int unit, unsigned int sampler) {
+  if (unit < kMaxTextureUnits && samplers_[unit] == sampler) {
+    counters_.skipped++;
+    return;
+  }
+  // Sampler bindings name their unit directly, no glActiveTexture needed
+  GLCall(glBindSampler(unit, sampler));
+  counters_.issued++;
+  if (unit < kMaxTextureUnits) samplers_[unit] = sampler;
+}
+
+// Deleting a bound object resets its bindings in the current context, and its name may be handed out
+// again by the next glGen* call, so the cached binding must not survive it
+void GLStateCache::OnDeleteProgram(unsigned int program) {
+  if (program_ == program) program_ = kUnknown;
+}
+
+void GLStateCache::OnDeleteVertexArray(unsigned int vao) {
+  if (vao_ == vao) {
+    vao_ = kUnknown;
+    element_buffer_ = kUnknown;
+  }
+  vao_element_buffers_.erase(vao);
+}
+
+void GLStateCache::OnDeleteBuffer(unsigned int buffer) {
+  if (array_buffer_ == buffer) array_buffer_ = kUnknown;
+  if (element_buffer_ == buffer) element_buffer_ = kUnknown;
+  for (auto& [vao, element_buffer] : vao_element_buffers_) {
+    if (element_buffer == buffer) element_buffer = kUnknown;
+  }
+}
+
+void GLStateCache::OnDeleteTexture(unsigned int texture) {
+  for (auto& unit : textures_) {
+    for (unsigned int& bound : unit) {
+      if (bound == texture) bound = kUnknown;
+    }
+  }
+}
+
+void GLStateCache::OnDeleteSampler(unsigned int sampler) {
+  for (unsigned int& bound : samplers_) {
+    if (bound == sampler) bound = kUnknown;
+  }
+}
+
+void GLStateCache::Invalidate() {
+  program_ = kUnknown;
+  vao_ = kUnknown;
+  array_buffer_ = kUnknown;
+  element_buffer_ = kUnknown;
+  active_unit_ = kUnknown;
+  for (auto& unit : textures_) unit.fill(kUnknown);
+  samplers_.fill(kUnknown);
+  vao_element_buffers_.clear();
+}
+
+void GLStateCache::EndFrame() {
+  last_frame_counters_ = counters_;
+  counters_ = Counters();
+}
+
+int GLStateCache::TextureTargetIndex(unsigned int target) {
+  switch (target) {
+    case GL_TEXTURE_2D:
+      return 0;
+    case GL_TEXTURE_2D_ARRAY:
+      return 1;
+  }
+  return -1;
+}
@@ -1,16 +1,32 @@
 #include "index_buffer.h"
+#include "gl_state_cache.h"
 #include "renderer.h"
 
 IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count) : count_(count) {
   ASSERT(sizeof(unsigned int) == sizeof(GLuint));
 
   GLCall(glGenBuffers(1, &renderer_id_));
-  GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderer_id_));
+  Bind();
   GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW));
 }
 
-IndexBuffer::~IndexBuffer() { GLCall(glDeleteBuffers(1, &renderer_id_)); }
+IndexBuffer::IndexBuffer(unsigned int count) : count_(count) {
+  GLCall(glGenBuffers(1, &renderer_id_));
+  Bind();
+  GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), nullptr, GL_DYNAMIC_DRAW));
+}
+
+IndexBuffer::~IndexBuffer() {
+  GLCall(glDeleteBuffers(1, &renderer_id_));
+  GLStateCache::Get().OnDeleteBuffer(renderer_id_);
+}
+
+void IndexBuffer::Bind() const { GLStateCache::Get().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderer_id_); }
 
-void IndexBuffer::Bind() const { GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderer_id_)); }
+void IndexBuffer::Unbind() const { GLStateCache::Get().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); }
 
-void IndexBuffer::Unbind() const { GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0)); }
+void IndexBuffer::SubData(unsigned int first, const unsigned int* data, unsigned int count) {
+  ASSERT(first + count <= count_);
+  Bind();
+  GLCall(glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, first * sizeof(unsigned int), count * sizeof(unsigned int), data));
+}
@@ -0,0 +1,246 @@
+#include "job_system.h"
+#include <cstdlib>
+#include <iostream>
+#include "imgui.h"
+#include "trace_recorder.h"
+
+// Chase-Lev deque of a fixed capacity, with the memory orders of Lê et al., "Correct and Efficient
+// Work-Stealing for Weak Memory Models". Push and Pop are for the owning thread only, Steal for any thread
+class WorkStealingDeque {
+public:
+  static constexpr int64_t kCapacity = JobSystem::kJobsPerThread;
+  static_assert((kCapacity & (kCapacity - 1)) == 0, "capacity must be a power of two");
+
+  // False when full
+  bool Push(Job* job) {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    int64_t top = top_.load(std::memory_order_acquire);
+    if (bottom - top >= kCapacity) return false;
+    jobs_[bottom & (kCapacity - 1)].store(job, std::memory_order_relaxed);
+    // Same as the paper's release fence before a relaxed store, and visible to thread sanitizers
+    bottom_.store(bottom + 1, std::memory_order_release);
+    return true;
+  }
+
+  Job* Pop() {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = top_.load(std::memory_order_relaxed);
+    if (top > bottom) {
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+
+    Job* job = jobs_[bottom & (kCapacity - 1)].load(std::memory_order_relaxed);
+    if (top == bottom) {
+      // The last job, a thief may be taking it at the same time
+      if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        job = nullptr;
+      }
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return job;
+  }
+
+  Job* Steal() {
+    int64_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom) return nullptr;
+
+    Job* job = jobs_[top & (kCapacity - 1)].load(std::memory_order_relaxed);
+    // Lost the race to the owner or another thief; the caller just looks elsewhere
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return job;
+  }
+
+private:
+  alignas(64) std::atomic<int64_t> top_{0};
+  alignas(64) std::atomic<int64_t> bottom_{0};
+  alignas(64) std::array<std::atomic<Job*>, kCapacity> jobs_{};
+};
+
+struct JobSystem::Queue {
+  WorkStealingDeque deque;
+  // Ring the owner allocates its jobs from
+  std::unique_ptr<Job[]> jobs = std::make_unique<Job[]>(kJobsPerThread);
+  unsigned int next_job = 0;
+  uint32_t steal_seed = 0;
+};
+
+// Index into queues_ of the calling thread's queue, or -1 before it queued or waited for anything
+static thread_local int t_queue = -1;
+
+JobSystem& JobSystem::Get() {
+  static JobSystem jobs;
+  return jobs;
+}
+
+JobSystem::JobSystem()
+    : queue_count_(0), worker_count_(0), stopping_(false), epoch_(0), sleepers_(0), slider_workers_(0) {}
+
+JobSystem::~JobSystem() { Shutdown(); }
+
+unsigned int JobSystem::GetDefaultWorkerCount() {
+  unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+  // Leave queues for the main and simulation threads
+  return std::min(threads - 1, kMaxThreads - 4);
+}
+
+void JobSystem::Start(unsigned int workers) {
+  Shutdown();
+  workers = std::min(workers, kMaxThreads - 4);
+  stopping_.store(false);
+  for (unsigned int i = 0; i < workers; i++) workers_.emplace_back(&JobSystem::WorkerLoop, this);
+  worker_count_.store(workers, std::memory_order_relaxed);
+}
+
+void JobSystem::Shutdown() {
+  if (workers_.empty()) return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_.store(true);
+  }
+  cv_.notify_all();
+  for (std::thread& worker : workers_) worker.join();
+  workers_.clear();
+  worker_count_.store(0, std::memory_order_relaxed);
+}
+
+JobSystem::Queue& JobSystem::GetQueue() {
+  if (t_queue < 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!free_queues_.empty()) {
+      t_queue = (int)free_queues_.back();
+      free_queues_.pop_back();
+    } else {
+      unsigned int index = queue_count_.load(std::memory_order_relaxed);
+      if (index == kMaxThreads) {
+        // A deque has exactly one owner, sharing one would corrupt it
+        std::cout << "JobSystem: more than " << kMaxThreads << " threads queue jobs" << std::endl;
+        std::abort();
+      }
+      queues_[index] = std::make_unique<Queue>();
+      queues_[index]->steal_seed = index * 2654435761u + 1;
+      queue_count_.store(index + 1, std::memory_order_release);
+      t_queue = (int)index;
+    }
+  }
+  return *queues_[t_queue];
+}
+
+Job* JobSystem::AllocateJob() {
+  // Slots are handed out in order, so if the next one is still busy the ring is full
+  Queue& queue = GetQueue();
+  Job& job = queue.jobs[queue.next_job & (kJobsPerThread - 1)];
+  if (!job.free.load(std::memory_order_acquire)) return nullptr;
+  job.free.store(false, std::memory_order_relaxed);
+  queue.next_job++;
+  return &job;
+}
+
+void JobSystem::Schedule(Job* job) {
+  // A full deque means the thread is far ahead of the workers, so it might as well do the job itself
+  if (!GetQueue().deque.Push(job)) {
+    Execute(*job);
+    return;
+  }
+
+  // Pairs with the worker bumping sleepers_ before it checks the epoch: one of the two sees the other
+  epoch_.fetch_add(1, std::memory_order_seq_cst);
+  if (sleepers_.load(std::memory_order_seq_cst) != 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cv_.notify_one();
+  }
+}
+
+Job* JobSystem::FindJob(Queue& queue) {
+  if (Job* job = queue.deque.Pop()) return job;
+
+  // Steal, starting at a random queue so thieves spread out
+  unsigned int count = queue_count_.load(std::memory_order_acquire);
+  queue.steal_seed ^= queue.steal_seed << 13;
+  queue.steal_seed ^= queue.steal_seed >> 17;
+  queue.steal_seed ^= queue.steal_seed << 5;
+  unsigned int start = queue.steal_seed % count;
+  for (unsigned int i = 0; i < count; i++) {
+    Queue& victim = *queues_[(start + i) % count];
+    if (&victim == &queue) continue;
+    if (Job* job = victim.deque.Steal()) return job;
+  }
+  return nullptr;
+}
+
+void JobSystem::Execute(Job& job) {
+  JobCounter& counter = *job.counter;
+  job.function(job);
+  // Nothing below touches the job, so its slot can be reused right away
+  job.free.store(true, std::memory_order_release);
+
+  counter.finishing_.fetch_add(1, std::memory_order_relaxed);
+  if (counter.count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    std::vector<Job*> continuations;
+    {
+      std::lock_guard<std::mutex> lock(counter.mutex_);
+      continuations.swap(counter.continuations_);
+    }
+    for (Job* continuation : continuations) Schedule(continuation);
+  }
+  // Last access; a waiter may destroy the counter from here on
+  counter.finishing_.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+  Queue& queue = GetQueue();
+  while (!counter.IsDone()) {
+    if (Job* job = FindJob(queue)) {
+      Execute(*job);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void JobSystem::WorkerLoop() {
+  TraceRecorder::Get().SetThreadName("Job worker");
+  Queue& queue = GetQueue();
+
+  while (true) {
+    uint64_t epoch = epoch_.load(std::memory_order_seq_cst);
+    if (Job* job = FindJob(queue)) {
+      Execute(*job);
+      continue;
+    }
+    // Only exits once there is nothing left to steal, its own deque included
+    if (stopping_.load()) break;
+
+    sleepers_.fetch_add(1, std::memory_order_seq_cst);
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [&]() { return stopping_.load() || epoch_.load(std::memory_order_seq_cst) != epoch; });
+    }
+    sleepers_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  TraceRecorder::Get().ReleaseThreadBuffer();
+  std::lock_guard<std::mutex> lock(mutex_);
+  free_queues_.push_back((unsigned int)t_queue);
+  t_queue = -1;
+}
+
+void JobSystem::OnImGuiRender() {
+  if (!ImGui::CollapsingHeader("Jobs")) return;
+  int max_workers = (int)std::min(std::max(1u, std::thread::hardware_concurrency()) * 2, kMaxThreads - 4);
+  ImGui::SliderInt("workers", &slider_workers_, 0, max_workers);
+  // Restarting joins every worker, so it waits for the slider to be let go. Only called between frames,
+  // when no jobs are running
+  if (ImGui::IsItemDeactivatedAfterEdit()) {
+    Start((unsigned int)slider_workers_);
+  } else if (!ImGui::IsItemActive()) {
+    slider_workers_ = (int)GetWorkerCount();
+  }
+  ImGui::Text("%u hardware threads", std::thread::hardware_concurrency());
+}
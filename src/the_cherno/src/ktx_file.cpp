@@ -0,0 +1,136 @@
+#include "ktx_file.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "mipmap.h"
+
+namespace {
+
+constexpr uint8_t kIdentifier[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+constexpr uint32_t kEndianness = 0x04030201;
+
+struct KtxHeader {
+  uint8_t identifier[12];
+  uint32_t endianness;
+  uint32_t gl_type;
+  uint32_t gl_type_size;
+  uint32_t gl_format;
+  uint32_t gl_internal_format;
+  uint32_t gl_base_internal_format;
+  uint32_t pixel_width;
+  uint32_t pixel_height;
+  uint32_t pixel_depth;
+  uint32_t array_elements;
+  uint32_t faces;
+  uint32_t mip_levels;
+  uint32_t key_value_bytes;
+};
+static_assert(sizeof(KtxHeader) == 64);
+
+}  // namespace
+
+size_t CompressedImageView::GetSize() const {
+  size_t size = 0;
+  for (const Level& level : levels) size += level.size;
+  return size;
+}
+
+size_t CompressedImage::GetSize() const {
+  size_t size = 0;
+  for (const Level& level : levels) size += level.data.size();
+  return size;
+}
+
+CompressedImageView CompressedImage::GetView() const {
+  CompressedImageView view = {format, width, height, {}};
+  for (const Level& level : levels) {
+    view.levels.push_back({level.width, level.height, level.data.data(), level.data.size()});
+  }
+  return view;
+}
+
+bool IsKtxPath(const std::string& path) { return path.size() >= 4 && path.compare(path.size() - 4, 4, ".ktx") == 0; }
+
+bool ParseKtx(const uint8_t* bytes, size_t size, CompressedImageView& image) {
+  KtxHeader header;
+  if (size < sizeof(header)) {
+    std::cout << "KTX: file too small" << std::endl;
+    return false;
+  }
+  memcpy(&header, bytes, sizeof(header));
+  if (memcmp(header.identifier, kIdentifier, sizeof(kIdentifier)) != 0 || header.endianness != kEndianness) {
+    std::cout << "KTX: not a little endian KTX 1.1 file" << std::endl;
+    return false;
+  }
+  if (header.gl_type != 0 || !GetBlockFormat(header.gl_internal_format, image.format)) {
+    std::cout << "KTX: unsupported format 0x" << std::hex << header.gl_internal_format << std::dec << std::endl;
+    return false;
+  }
+  if (header.pixel_depth > 1 || header.array_elements > 0 || header.faces != 1 || header.pixel_width == 0) {
+    std::cout << "KTX: only single 2D images are supported" << std::endl;
+    return false;
+  }
+
+  image.width = header.pixel_width;
+  image.height = std::max<uint32_t>(header.pixel_height, 1);
+  image.levels.clear();
+
+  // glTexStorage2D rejects more levels than the full chain, and the level sizes below can't shift that far
+  uint32_t level_count = std::max<uint32_t>(header.mip_levels, 1);
+  if (level_count > (uint32_t)GetMipLevelCount(image.width, image.height)) {
+    std::cout << "KTX: " << level_count << " mip levels for a " << image.width << "x" << image.height << " image"
+              << std::endl;
+    return false;
+  }
+
+  size_t offset = sizeof(header) + header.key_value_bytes;
+  for (uint32_t i = 0; i < level_count; i++) {
+    uint32_t image_size;
+    if (offset + sizeof(image_size) > size) {
+      std::cout << "KTX: level " << i << " is truncated or has the wrong size" << std::endl;
+      return false;
+    }
+    memcpy(&image_size, bytes + offset, sizeof(image_size));
+    offset += sizeof(image_size);
+
+    CompressedImageView::Level level;
+    level.width = std::max(1, image.width >> i);
+    level.height = std::max(1, image.height >> i);
+    if (image_size != GetCompressedSize(image.format, level.width, level.height) || offset + image_size > size) {
+      std::cout << "KTX: level " << i << " is truncated or has the wrong size" << std::endl;
+      return false;
+    }
+    level.data = bytes + offset;
+    level.size = image_size;
+    image.levels.push_back(level);
+    offset += (image_size + 3) & ~3u;  // mip padding
+  }
+  return true;
+}
+
+bool WriteKtx(const std::string& path, const CompressedImage& image) {
+  std::ofstream file(path, std::ios::binary);
+  if (!file) return false;
+
+  KtxHeader header = {};
+  memcpy(header.identifier, kIdentifier, sizeof(kIdentifier));
+  header.endianness = kEndianness;
+  header.gl_type_size = 1;
+  header.gl_internal_format = GetGLInternalFormat(image.format);
+  header.gl_base_internal_format = GetGLBaseFormat(image.format);
+  header.pixel_width = image.width;
+  header.pixel_height = image.height;
+  header.faces = 1;
+  header.mip_levels = image.levels.size();
+  file.write((const char*)&header, sizeof(header));
+
+  const char padding[3] = {};
+  for (const CompressedImage::Level& level : image.levels) {
+    uint32_t image_size = level.data.size();
+    file.write((const char*)&image_size, sizeof(image_size));
+    file.write((const char*)level.data.data(), image_size);
+    file.write(padding, (4 - image_size % 4) % 4);
+  }
+  return file.good();
+}
@@ -5,14 +5,21 @@
 
 #include <cstdlib>
 #include "glm/gtc/matrix_transform.hpp"  // IWYU pragma: keep
+#include "frame_clock.h"
+#include "frame_pacer.h"
+#include "frame_pipeline.h"
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
+#include "job_system.h"
+#include "profiler.h"
 #include "renderer.h"
+#include "shader_library.h"
 #include "test.h"
-#include "test_batch_render.h"
-#include "test_clear_color.h"
-#include "test_texture2d.h"
+#include "texture_loader.h"
+#include "trace_recorder.h"
 
 constexpr int kScreenWidth = 800;
 constexpr int kScreenHeight = 600;
@@ -28,6 +35,9 @@ int main() {
 #ifdef __APPLE__
   glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+#if GL_ERROR_POLICY == GL_ERROR_POLICY_DEBUG_OUTPUT
+  glfwWindowHint(GLFW_CONTEXT_DEBUG, GL_TRUE);
+#endif
 
   GLFWwindow* window = glfwCreateWindow(kScreenWidth, kScreenHeight, "ck::cherno_opengl_tutorial", NULL, NULL);
   if (!window) {
@@ -47,19 +57,28 @@ int main() {
     return -1;
   }
   printf("Loaded OpenGL %d.%d\n", GLAD_VERSION_MAJOR(version), GLAD_VERSION_MINOR(version));
+  LoadGLExtensions(glfwGetProcAddress);
+#if GL_ERROR_POLICY == GL_ERROR_POLICY_DEBUG_OUTPUT
+  if (!GLEnableDebugOutput()) {
+    printf("KHR_debug unavailable, checking glGetError after every GL call\n");
+  }
+#endif
 
   /*──────────┐
   │ Variables │
   └───────────*/
 
+  // Submit every program up front; the driver compiles them while the first frames render
+  ShaderLibrary& shader_library = ShaderLibrary::Get();
+  shader_library.Load("instanced", "assets/shaders/instanced.shader");
+  shader_library.Load("batch", "assets/shaders/batch.shader");
+
   Renderer renderer;
   test::Test* current_test = nullptr;
   test::TestMenu* test_menu = new test::TestMenu(current_test);
   current_test = test_menu;
 
-  test_menu->RegisterTest<test::TestClearColor>("Clear Color");
-  test_menu->RegisterTest<test::TestTexture2D>("2D Texture");
-  test_menu->RegisterTest<test::TestBatchRender>("Batch Render");
+  test::RegisterTests(*test_menu);
 
   /*────────────┐
   │ ImGUi Setup │
@@ -79,39 +98,125 @@ int main() {
   │ Main Loop │
   └───────────*/
 
+  Profiler& profiler = Profiler::Get();
+  TraceRecorder& trace = TraceRecorder::Get();
+  trace.SetThreadName("Main");
+  JobSystem& jobs = JobSystem::Get();
+  jobs.Start(JobSystem::GetDefaultWorkerCount());
+  test::Test* profiled_test = current_test;
+
+  FrameClock clock;
+  FramePacer pacer;
+  FramePipeline pipeline;
+  if (const GLFWvidmode* mode = glfwGetVideoMode(glfwGetPrimaryMonitor())) pacer.SetRefreshRate(mode->refreshRate);
+  int swap_interval = pacer.GetSwapInterval();
+
   while (!glfwWindowShouldClose(window)) {
+    {
+      TRACE_SCOPE("Frame pacing");
+      pacer.WaitForFrameStart();
+    }
+    {
+      // Input is read after the pacing wait, as close to the frame that uses it as the mode allows
+      TRACE_SCOPE("PollEvents");
+      GLCall(glfwPollEvents());
+    }
+    double dt = clock.Tick();
+    if (pacer.GetSwapInterval() != swap_interval) {
+      swap_interval = pacer.GetSwapInterval();
+      glfwSwapInterval(swap_interval);
+    }
+
+    // Every test starts with a clean breakdown
+    if (current_test != profiled_test) {
+      profiler.Reset();
+      profiled_test = current_test;
+    }
+    profiler.BeginFrame();
+
     // Render here
-    renderer.Clear();
+    {
+      TRACE_SCOPE("Clear");
+      renderer.Clear();
+    }
 
     // Start Dear ImGui frame
-    ImGui_ImplOpenGL3_NewFrame();
-    ImGui_ImplGlfw_NewFrame();
-    ImGui::NewFrame();
+    {
+      TRACE_SCOPE("ImGui NewFrame");
+      ImGui_ImplOpenGL3_NewFrame();
+      ImGui_ImplGlfw_NewFrame();
+      ImGui::NewFrame();
+    }
+    {
+      PROFILE_SCOPE("Update");
+      shader_library.Update();
+      TextureLoader::Get().Update();
+    }
     if (current_test) {
-      current_test->OnUpdate(0.0f);
-      current_test->OnRender();
-      ImGui::Begin("Test");
-      if (current_test != test_menu && ImGui::Button("<-")) {
-        delete current_test;
-        current_test = test_menu;
+      {
+        PROFILE_SCOPE("Test UI");
+        // The simulation thread stays idle from here until RunFrame, so the UI may change the test
+        pipeline.Sync();
+        test::Test* shown_test = current_test;
+        ImGui::Begin("Test");
+        if (current_test != test_menu && ImGui::Button("<-")) {
+          delete current_test;
+          current_test = test_menu;
+        }
+        current_test->OnImGuiRender();
+        // A packet recorded by the previous test points at its GL objects
+        if (current_test != shown_test) pipeline.Discard();
+
+        const GLStateCache::Counters& binds = GLStateCache::Get().GetLastFrameCounters();
+        ImGui::Text("GL binds: %u issued, %u skipped", binds.issued, binds.skipped);
+        if (current_test->UsesFramePackets()) {
+          bool threaded = pipeline.IsThreaded();
+          if (ImGui::Checkbox("simulation thread", &threaded)) pipeline.SetThreaded(threaded);
+        }
+        if (current_test != test_menu) profiler.OnImGuiRender();
+        trace.OnImGuiRender();
+        pacer.OnImGuiRender();
+        jobs.OnImGuiRender();
+        ImGui::End();
       }
-      current_test->OnImGuiRender();
-      ImGui::End();
+      PROFILE_GPU_SCOPE("Render");
+      pipeline.RunFrame(*current_test, dt);
     }
 
     // Render Dear ImGui
-    ImGui::Render();
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    {
+      PROFILE_GPU_SCOPE("ImGui");
+      {
+        TRACE_SCOPE("ImGui::Render");
+        ImGui::Render();
+      }
+      TRACE_SCOPE("RenderDrawData");
+      ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    }
 
     // Update
-    GLCall(glfwSwapBuffers(window));
-    GLCall(glfwPollEvents());
+    GLStateCache::Get().EndFrame();
+    {
+      // Includes the wait for vsync
+      PROFILE_SCOPE("Present");
+      pacer.OnFrameSubmitted();
+      GLCall(glfwSwapBuffers(window));
+      pacer.OnFramePresented();
+    }
+    profiler.EndFrame();
+    trace.EndFrame();
   }
 
+  // Stops the simulation thread before the test it may be working on goes away
+  pipeline.Shutdown();
+  jobs.Shutdown();
   delete current_test;
   if (current_test != test_menu) {
     delete test_menu;
   }
+  shader_library.Clear();
+  TextureLoader::Get().Shutdown();
+  profiler.Shutdown();
 
   // Cleanup Dear ImGui
   ImGui_ImplOpenGL3_Shutdown();
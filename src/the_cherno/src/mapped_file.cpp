@@ -0,0 +1,96 @@
+#include "mapped_file.h"
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() : data_(nullptr), size_(0), mapping_(nullptr) {}
+
+MappedFile::MappedFile(const std::string& path) : MappedFile() { Open(path); }
+
+MappedFile::~MappedFile() { Close(); }
+
+MappedFile::MappedFile(MappedFile&& other) noexcept : MappedFile() { *this = std::move(other); }
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this == &other) return *this;
+  Close();
+  // Moving a vector keeps its buffer, so data_ stays valid either way
+  data_ = std::exchange(other.data_, nullptr);
+  size_ = std::exchange(other.size_, 0);
+  mapping_ = std::exchange(other.mapping_, nullptr);
+  fallback_ = std::move(other.fallback_);
+  return *this;
+}
+
+bool MappedFile::Open(const std::string& path) {
+  Close();
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file != INVALID_HANDLE_VALUE) {
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+      HANDLE map = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (map) {
+        mapping_ = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(map);  // the view keeps the mapping alive
+      }
+      size_ = (size_t)size.QuadPart;
+    }
+    CloseHandle(file);
+  }
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+      void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapping != MAP_FAILED) {
+        // Decoders and uploads read front to back
+        madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+        mapping_ = mapping;
+      }
+      size_ = (size_t)info.st_size;
+    }
+    close(fd);  // the mapping holds its own reference to the file
+  }
+#endif
+
+  if (mapping_) {
+    data_ = (const uint8_t*)mapping_;
+    return true;
+  }
+
+  std::ifstream file(path, std::ios::binary);
+  fallback_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  size_ = fallback_.size();
+  data_ = fallback_.empty() ? nullptr : fallback_.data();
+  return data_ != nullptr;
+}
+
+void MappedFile::Close() {
+  if (mapping_) {
+#ifdef _WIN32
+    UnmapViewOfFile(mapping_);
+#else
+    munmap(mapping_, size_);
+#endif
+  }
+  mapping_ = nullptr;
+  data_ = nullptr;
+  size_ = 0;
+  fallback_.clear();
+  fallback_.shrink_to_fit();
+}
@@ -0,0 +1,48 @@
+#include "mesh_buffer.h"
+#include "renderer.h"
+#include "vertex_buffer_layout.h"
+
+MeshBuffer::MeshBuffer(const VertexBufferLayout& layout, unsigned int max_vertices, unsigned int max_indices)
+    : stride_(layout.GetStride()),
+      max_vertices_(max_vertices),
+      max_indices_(max_indices),
+      vertex_count_(0),
+      index_count_(0) {
+  vao_ = std::make_unique<VertexArray>();
+  vertex_buffer_ = std::make_unique<VertexBuffer>(max_vertices * stride_);
+  vao_->AddBuffer(*vertex_buffer_, layout);
+
+  // Created while the vao is bound, so the element buffer binding is recorded in it
+  index_buffer_ = std::make_unique<IndexBuffer>(max_indices);
+  vao_->Unbind();
+}
+
+MeshBuffer::~MeshBuffer() {}
+
+MeshRange MeshBuffer::Add(const void* vertices, unsigned int vertex_count, const unsigned int* indices,
+                          unsigned int index_count) {
+  if (vertex_count_ + vertex_count > max_vertices_ || index_count_ + index_count > max_indices_) {
+    std::cout << "Warning: MeshBuffer is full, " << vertex_count << " vertices / " << index_count
+              << " indices dropped" << std::endl;
+    return {};
+  }
+
+  MeshRange range;
+  range.first_index = index_count_;
+  range.index_count = index_count;
+  range.base_vertex = (int)vertex_count_;
+  range.vertex_count = vertex_count;
+
+  vertex_buffer_->SubData(vertex_count_ * stride_, vertices, vertex_count * stride_);
+  vao_->Bind();
+  index_buffer_->SubData(index_count_, indices, index_count);
+
+  vertex_count_ += vertex_count;
+  index_count_ += index_count;
+  return range;
+}
+
+void MeshBuffer::Clear() {
+  vertex_count_ = 0;
+  index_count_ = 0;
+}
@@ -0,0 +1,78 @@
+#include "mipmap.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIPMAP_SSE2 1
+#endif
+
+static inline uint8_t Average4(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { return (a + b + c + d + 2) >> 2; }
+
+void DownsampleBox2x(const uint8_t* src, int width, int height, uint8_t* dst) {
+  int dst_width = std::max(1, width / 2);
+  int dst_height = std::max(1, height / 2);
+  size_t src_stride = (size_t)width * 4;
+
+  for (int y = 0; y < dst_height; y++) {
+    const uint8_t* row0 = src + (size_t)std::min(2 * y, height - 1) * src_stride;
+    const uint8_t* row1 = src + (size_t)std::min(2 * y + 1, height - 1) * src_stride;
+    uint8_t* out = dst + (size_t)y * dst_width * 4;
+
+    int x = 0;
+#ifdef MIPMAP_SSE2
+    // 4 output pixels from 8 input pixels of each row. Widening to 16 bits keeps the exact
+    // (a + b + c + d + 2) / 4 result instead of chaining rounded averages
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+    for (; x + 4 <= dst_width && 2 * x + 8 <= width; x += 4) {
+      __m128i a = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+      __m128i b = _mm_loadu_si128((const __m128i*)(row0 + x * 8 + 16));
+      __m128i c = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+      __m128i d = _mm_loadu_si128((const __m128i*)(row1 + x * 8 + 16));
+
+      // Vertical sums of pixels 0-3 and 4-7, 16 bits per channel
+      __m128i lo0 = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(c, zero));  // px 0,1
+      __m128i hi0 = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(c, zero));  // px 2,3
+      __m128i lo1 = _mm_add_epi16(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(d, zero));  // px 4,5
+      __m128i hi1 = _mm_add_epi16(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(d, zero));  // px 6,7
+
+      // Horizontal: add the two pixels held in each register's low and high halves
+      __m128i s01 = _mm_add_epi16(lo0, _mm_srli_si128(lo0, 8));
+      __m128i s23 = _mm_add_epi16(hi0, _mm_srli_si128(hi0, 8));
+      __m128i s45 = _mm_add_epi16(lo1, _mm_srli_si128(lo1, 8));
+      __m128i s67 = _mm_add_epi16(hi1, _mm_srli_si128(hi1, 8));
+
+      __m128i sum_a = _mm_unpacklo_epi64(s01, s23);
+      __m128i sum_b = _mm_unpacklo_epi64(s45, s67);
+      sum_a = _mm_srli_epi16(_mm_add_epi16(sum_a, two), 2);
+      sum_b = _mm_srli_epi16(_mm_add_epi16(sum_b, two), 2);
+      _mm_storeu_si128((__m128i*)(out + x * 4), _mm_packus_epi16(sum_a, sum_b));
+    }
+#endif
+    for (; x < dst_width; x++) {
+      int x0 = std::min(2 * x, width - 1) * 4;
+      int x1 = std::min(2 * x + 1, width - 1) * 4;
+      for (int c = 0; c < 4; c++) {
+        out[x * 4 + c] = Average4(row0[x0 + c], row0[x1 + c], row1[x0 + c], row1[x1 + c]);
+      }
+    }
+  }
+}
+
+std::vector<MipLevel> GenerateMipChain(const uint8_t* pixels, int width, int height) {
+  std::vector<MipLevel> levels;
+  const uint8_t* src = pixels;
+  while (width > 1 || height > 1) {
+    MipLevel level;
+    level.width = std::max(1, width / 2);
+    level.height = std::max(1, height / 2);
+    level.pixels.resize((size_t)level.width * level.height * 4);
+    DownsampleBox2x(src, width, height, level.pixels.data());
+
+    width = level.width;
+    height = level.height;
+    levels.push_back(std::move(level));
+    src = levels.back().pixels.data();
+  }
+  return levels;
+}
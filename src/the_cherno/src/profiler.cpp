@@ -0,0 +1,271 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include "imgui.h"
+#include "renderer.h"
+
+static const char* const kFrameScope = "Frame";
+
+// Set on the thread that calls BeginFrame; scopes on any other thread are ignored
+static thread_local bool t_profiling_thread = false;
+
+Profiler& Profiler::Get() {
+  static Profiler profiler;
+  return profiler;
+}
+
+Profiler::Profiler()
+    : enabled_(true), in_frame_(false), gpu_supported_(false), gpu_checked_(false), frame_(0), dropped_frames_(0) {}
+
+void Profiler::BeginFrame() {
+  ASSERT(!in_frame_);
+  t_profiling_thread = true;
+  if (!gpu_checked_) {
+    // Timer queries are core since 3.3, but an implementation may still report a counter without any bits
+    int bits = 0;
+    GLCall(glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits));
+    gpu_supported_ = bits > 0;
+    gpu_checked_ = true;
+  }
+
+  // The slot this frame reuses was last filled kFrameLatency frames ago
+  FrameQueries& queries = queries_[frame_ % kFrameLatency];
+  if (queries.pending) ResolveQueries(queries);
+  queries.used = 0;
+  queries.scopes.clear();
+
+  if (!enabled_) return;
+  in_frame_ = true;
+  current_order_.clear();
+  BeginScope(kFrameScope, true);
+}
+
+void Profiler::EndFrame() {
+  if (in_frame_) {
+    EndScope();
+    ASSERT(stack_.empty());
+    in_frame_ = false;
+
+    for (int index : current_order_) {
+      History& history = histories_[index];
+      history.PushCpu(history.frame_cpu_ms);
+      history.calls = history.frame_calls;
+    }
+    frame_order_.swap(current_order_);
+    queries_[frame_ % kFrameLatency].pending = queries_[frame_ % kFrameLatency].used != 0;
+  }
+  frame_++;
+}
+
+bool Profiler::BeginScope(const char* name, bool gpu) {
+  if (!t_profiling_thread || !in_frame_) return false;
+
+  int index = FindHistory(stack_.empty() ? -1 : stack_.back().history, name);
+  History& history = histories_[index];
+  if (history.frame != frame_) {
+    history.frame = frame_;
+    history.frame_cpu_ms = 0.0f;
+    history.frame_calls = 0;
+    current_order_.push_back(index);
+  }
+  history.frame_calls++;
+  history.gpu |= gpu && gpu_supported_;
+
+  int query = -1;
+  if (gpu && gpu_supported_) {
+    query = AllocateQuery();
+    AllocateQuery();  // the end timestamp
+    FrameQueries& queries = queries_[frame_ % kFrameLatency];
+    GLCall(glQueryCounter(queries.ids[query], GL_TIMESTAMP));
+    queries.scopes.emplace_back(index, query);
+  }
+  stack_.push_back({index, std::chrono::steady_clock::now(), query});
+  return true;
+}
+
+void Profiler::EndScope() {
+  ASSERT(!stack_.empty());
+  OpenScope scope = stack_.back();
+  stack_.pop_back();
+
+  if (scope.query >= 0) {
+    GLCall(glQueryCounter(queries_[frame_ % kFrameLatency].ids[scope.query + 1], GL_TIMESTAMP));
+  }
+  std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - scope.start;
+  histories_[scope.history].frame_cpu_ms += elapsed.count();
+}
+
+void Profiler::Reset() {
+  ASSERT(!in_frame_);
+  histories_.clear();
+  lookup_.clear();
+  frame_order_.clear();
+  current_order_.clear();
+  // In-flight queries point at histories that are gone
+  for (FrameQueries& queries : queries_) {
+    queries.pending = false;
+    queries.scopes.clear();
+  }
+  dropped_frames_ = 0;
+}
+
+void Profiler::Shutdown() {
+  Reset();
+  for (FrameQueries& queries : queries_) {
+    if (!queries.ids.empty()) {
+      GLCall(glDeleteQueries((int)queries.ids.size(), queries.ids.data()));
+    }
+    queries.ids.clear();
+    queries.used = 0;
+  }
+  gpu_checked_ = false;
+}
+
+int Profiler::FindHistory(int parent, const char* name) {
+  auto it = lookup_.find({parent, name});
+  if (it != lookup_.end()) return it->second;
+
+  History history;
+  history.name = name;
+  history.parent = parent;
+  histories_.push_back(history);
+  int index = (int)histories_.size() - 1;
+  lookup_.emplace(std::make_pair(parent, name), index);
+  return index;
+}
+
+int Profiler::AllocateQuery() {
+  FrameQueries& queries = queries_[frame_ % kFrameLatency];
+  if (queries.used == queries.ids.size()) {
+    // Grow in chunks; the pool settles after the first frames and is reused from then on
+    size_t first = queries.ids.size();
+    queries.ids.resize(first + 32);
+    GLCall(glGenQueries(32, queries.ids.data() + first));
+  }
+  return (int)queries.used++;
+}
+
+void Profiler::ResolveQueries(FrameQueries& queries) {
+  queries.pending = false;
+
+  // Timestamps complete in order, so the last one being available means all of them are
+  int available = 0;
+  GLCall(glGetQueryObjectiv(queries.ids[queries.used - 1], GL_QUERY_RESULT_AVAILABLE, &available));
+  if (!available) {
+    dropped_frames_++;
+    return;
+  }
+
+  std::vector<float> frame_ms(histories_.size(), -1.0f);
+  for (const auto& [index, query] : queries.scopes) {
+    uint64_t begin = 0, end = 0;
+    GLCall(glGetQueryObjectui64v(queries.ids[query], GL_QUERY_RESULT, &begin));
+    GLCall(glGetQueryObjectui64v(queries.ids[query + 1], GL_QUERY_RESULT, &end));
+    frame_ms[index] = std::max(frame_ms[index], 0.0f) + (end - begin) / 1e6f;
+  }
+  for (size_t i = 0; i < frame_ms.size(); i++) {
+    if (frame_ms[i] >= 0.0f) histories_[i].PushGpu(frame_ms[i]);
+  }
+}
+
+Profiler::ScopeStats Profiler::ComputeStats(const std::array<float, kHistory>& samples, unsigned int count) {
+  ScopeStats stats;
+  unsigned int n = std::min(count, kHistory);
+  if (n == 0) return stats;
+
+  std::array<float, kHistory> sorted;
+  std::copy_n(samples.begin(), n, sorted.begin());
+  std::sort(sorted.begin(), sorted.begin() + n);
+  float sum = 0.0f;
+  for (unsigned int i = 0; i < n; i++) sum += sorted[i];
+
+  stats.min = sorted[0];
+  stats.avg = sum / n;
+  stats.p99 = sorted[std::max(1u, (n * 99 + 99) / 100) - 1];  // nearest rank
+  stats.last = samples[(count - 1) % kHistory];
+  return stats;
+}
+
+void Profiler::OnImGuiRender() {
+  if (!ImGui::CollapsingHeader("Profiler", ImGuiTreeNodeFlags_DefaultOpen)) return;
+
+  ImGui::Checkbox("enabled", &enabled_);
+  if (!gpu_supported_) {
+    ImGui::SameLine();
+    ImGui::TextDisabled("(no GPU timestamps)");
+  }
+  if (dropped_frames_ != 0) {
+    ImGui::SameLine();
+    ImGui::Text("%u frames of GPU times dropped", dropped_frames_);
+  }
+  if (frame_order_.empty()) return;
+
+  // The graph shows the spikes an average hides; the ring buffer is drawn oldest sample first
+  const History& frame = histories_[frame_order_[0]];
+  ScopeStats cpu = ComputeStats(frame.cpu_ms, frame.cpu_count);
+  char overlay[64];
+  snprintf(overlay, sizeof(overlay), "CPU %.2f ms, p99 %.2f ms", cpu.last, cpu.p99);
+  ImGui::PlotLines("##cpu", frame.cpu_ms.data(), std::min(frame.cpu_count, kHistory),
+                   frame.cpu_count >= kHistory ? frame.cpu_count % kHistory : 0, overlay, 0.0f, FLT_MAX,
+                   ImVec2(0, 60));
+  if (frame.gpu) {
+    ScopeStats gpu = ComputeStats(frame.gpu_ms, frame.gpu_count);
+    snprintf(overlay, sizeof(overlay), "GPU %.2f ms, p99 %.2f ms", gpu.last, gpu.p99);
+    ImGui::PlotLines("##gpu", frame.gpu_ms.data(), std::min(frame.gpu_count, kHistory),
+                     frame.gpu_count >= kHistory ? frame.gpu_count % kHistory : 0, overlay, 0.0f, FLT_MAX,
+                     ImVec2(0, 60));
+  }
+
+  ImGuiTableFlags flags = ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit;
+  if (!ImGui::BeginTable("profiler_scopes", 8, flags)) return;
+  ImGui::TableSetupColumn("scope", ImGuiTableColumnFlags_WidthStretch);
+  ImGui::TableSetupColumn("calls");
+  ImGui::TableSetupColumn("cpu min");
+  ImGui::TableSetupColumn("cpu avg");
+  ImGui::TableSetupColumn("cpu p99");
+  ImGui::TableSetupColumn("gpu min");
+  ImGui::TableSetupColumn("gpu avg");
+  ImGui::TableSetupColumn("gpu p99");
+  ImGui::TableHeadersRow();
+  DrawRow(frame_order_[0]);
+  ImGui::EndTable();
+}
+
+void Profiler::DrawRow(int index) {
+  const History& history = histories_[index];
+  bool has_children = std::any_of(frame_order_.begin(), frame_order_.end(),
+                                  [&](int child) { return histories_[child].parent == index; });
+
+  ImGui::TableNextRow();
+  ImGui::TableNextColumn();
+  ImGui::PushID(index);
+  ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_DefaultOpen | ImGuiTreeNodeFlags_SpanFullWidth;
+  if (!has_children) flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+  bool open = ImGui::TreeNodeEx(history.name, flags);
+  ImGui::PopID();
+
+  ImGui::TableNextColumn();
+  ImGui::Text("%u", history.calls);
+  ScopeStats cpu = ComputeStats(history.cpu_ms, history.cpu_count);
+  for (float ms : {cpu.min, cpu.avg, cpu.p99}) {
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", ms);
+  }
+  ScopeStats gpu = ComputeStats(history.gpu_ms, history.gpu_count);
+  for (float ms : {gpu.min, gpu.avg, gpu.p99}) {
+    ImGui::TableNextColumn();
+    if (history.gpu) {
+      ImGui::Text("%.3f", ms);
+    } else {
+      ImGui::TextDisabled("-");
+    }
+  }
+
+  if (open && has_children) {
+    for (int child : frame_order_) {
+      if (histories_[child].parent == index) DrawRow(child);
+    }
+    ImGui::TreePop();
+  }
+}
@@ -0,0 +1,123 @@
+#include "program_binary_cache.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include "gl_extensions.h"
+#include "renderer.h"
+#include "shader.h"
+
+namespace {
+constexpr uint32_t kMagic = 0x31425043;  // "CPB1"
+
+struct FileHeader {
+  uint32_t magic;
+  uint32_t format;
+  uint64_t key;
+  uint32_t length;
+};
+
+uint64_t Fnv1a64(uint64_t hash, const std::string& data) {
+  for (char c : data) {
+    hash ^= (uint8_t)c;
+    hash *= 1099511628211ull;
+  }
+  // Separate fields so "ab"+"c" and "a"+"bc" hash differently
+  hash ^= 0xff;
+  hash *= 1099511628211ull;
+  return hash;
+}
+
+std::string GetGLString(GLenum name) {
+  const GLubyte* value;
+  GLCall(value = glGetString(name));
+  return value ? (const char*)value : "";
+}
+}  // namespace
+
+ProgramBinaryCache& ProgramBinaryCache::Get() {
+  static ProgramBinaryCache cache;
+  return cache;
+}
+
+ProgramBinaryCache::ProgramBinaryCache() : directory_(".cache/shaders"), enabled_(-1) {}
+
+bool ProgramBinaryCache::IsEnabled() {
+  if (enabled_ < 0) {
+    int formats = 0;
+    if (GLAD_GL_ARB_get_program_binary) GLCall(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats));
+    enabled_ = formats > 0;
+  }
+  return enabled_;
+}
+
+uint64_t ProgramBinaryCache::MakeKey(const ShaderProgramSource& source) {
+  uint64_t hash = 14695981039346656037ull;
+  hash = Fnv1a64(hash, source.VertexSource);
+  hash = Fnv1a64(hash, source.FragmentSource);
+  hash = Fnv1a64(hash, GetGLString(GL_VENDOR));
+  hash = Fnv1a64(hash, GetGLString(GL_RENDERER));
+  hash = Fnv1a64(hash, GetGLString(GL_VERSION));
+  return hash;
+}
+
+unsigned int ProgramBinaryCache::Load(uint64_t key) {
+  if (!IsEnabled()) return 0;
+
+  std::ifstream file(GetPath(key), std::ios::binary);
+  if (!file) return 0;
+
+  FileHeader header;
+  if (!file.read((char*)&header, sizeof(header)) || header.magic != kMagic || header.key != key) return 0;
+  std::vector<char> binary(header.length);
+  if (!file.read(binary.data(), binary.size())) return 0;
+
+  unsigned int program;
+  GLCall(program = glCreateProgram());
+  // Drivers report a rejected binary through the link status rather than a GL error
+  GLClearError();
+  glProgramBinary(program, header.format, binary.data(), binary.size());
+  GLClearError();
+
+  int linked = GL_FALSE;
+  GLCall(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+  if (linked == GL_FALSE) {
+    GLCall(glDeleteProgram(program));
+    return 0;
+  }
+  return program;
+}
+
+void ProgramBinaryCache::Store(uint64_t key, unsigned int program) {
+  if (!IsEnabled()) return;
+
+  int linked = GL_FALSE;
+  GLCall(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+  if (linked == GL_FALSE) return;
+
+  int length = 0;
+  GLCall(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+  if (length <= 0) return;
+
+  std::vector<char> binary(length);
+  GLenum format = 0;
+  GLCall(glGetProgramBinary(program, length, &length, &format, binary.data()));
+
+  std::error_code ec;
+  std::filesystem::create_directories(directory_, ec);
+  if (ec) {
+    std::cout << "Warning: can't create shader cache directory " << directory_ << std::endl;
+    return;
+  }
+
+  FileHeader header = {kMagic, format, key, (uint32_t)length};
+  std::ofstream file(GetPath(key), std::ios::binary | std::ios::trunc);
+  file.write((const char*)&header, sizeof(header));
+  file.write(binary.data(), length);
+}
+
+std::string ProgramBinaryCache::GetPath(uint64_t key) const {
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+  return directory_ + "/" + name;
+}
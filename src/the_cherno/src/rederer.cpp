@@ -1,4 +1,91 @@
 #include "renderer.h"
+#include <cstdint>
+#include "draw_indirect_buffer.h"
+#include "gl_extensions.h"
+#include "profiler.h"
+#include "glm/gtc/type_ptr.hpp"
+#include "render_command_bucket.h"
+#include "texture.h"
+
+struct GLCallSite {
+  const char* function = nullptr;
+  const char* file = nullptr;
+  int line = 0;
+};
+
+static bool s_debug_output = false;
+static Renderer::Stats s_stats;
+static thread_local GLCallSite s_call_site;
+static thread_local bool s_debug_error = false;
+
+static const char* DebugSourceName(GLenum source) {
+  switch (source) {
+    case GL_DEBUG_SOURCE_API:
+      return "API";
+    case GL_DEBUG_SOURCE_WINDOW_SYSTEM:
+      return "Window System";
+    case GL_DEBUG_SOURCE_SHADER_COMPILER:
+      return "Shader Compiler";
+    case GL_DEBUG_SOURCE_THIRD_PARTY:
+      return "Third Party";
+    case GL_DEBUG_SOURCE_APPLICATION:
+      return "Application";
+  }
+  return "Other";
+}
+
+static const char* DebugTypeName(GLenum type) {
+  switch (type) {
+    case GL_DEBUG_TYPE_ERROR:
+      return "Error";
+    case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+      return "Deprecated";
+    case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+      return "Undefined Behavior";
+    case GL_DEBUG_TYPE_PORTABILITY:
+      return "Portability";
+    case GL_DEBUG_TYPE_PERFORMANCE:
+      return "Performance";
+  }
+  return "Other";
+}
+
+static void GLAD_API_PTR DebugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                              GLsizei length, const GLchar* message, const void* user_param) {
+  std::cout << "[OpenGL " << DebugTypeName(type) << "] (" << DebugSourceName(source) << ", " << id
+            << "): " << message << std::endl;
+  if (s_call_site.function) {
+    std::cout << "  at " << s_call_site.function << " " << s_call_site.file << ":" << s_call_site.line << std::endl;
+  }
+  if (type == GL_DEBUG_TYPE_ERROR || severity == GL_DEBUG_SEVERITY_HIGH) {
+    s_debug_error = true;
+  }
+}
+
+bool GLEnableDebugOutput() {
+  if (!GLAD_GL_KHR_debug) return false;
+
+  // Synchronous output runs the callback inside the offending call, so the recorded call site is accurate
+  glEnable(GL_DEBUG_OUTPUT);
+  glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  glDebugMessageCallback(DebugMessageCallback, nullptr);
+  glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+  s_debug_output = true;
+  return true;
+}
+
+void GLBeginCall(const char* function, const char* file, int line) {
+  s_call_site = {function, file, line};
+  s_debug_error = false;
+  if (!s_debug_output) GLClearError();
+}
+
+bool GLEndCall() {
+  GLCallSite site = s_call_site;
+  s_call_site = GLCallSite();
+  if (s_debug_output) return !s_debug_error;
+  return GLLogCall(site.function, site.file, site.line);
+}
 
 void GLClearError() { while (glGetError() != GL_NO_ERROR); }
 
@@ -17,9 +104,160 @@ void Renderer::Clear() const {
 }
 
 void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const {
+  Draw(va, ib, shader, ib.GetCount());
+}
+
+void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int index_count,
+                    int base_vertex) const {
+  shader.Bind();
+  va.Bind();
+  ib.Bind();
+  s_stats.draw_calls++;
+  s_stats.draws++;
+
+  if (base_vertex == 0) {
+    GLCall(glDrawElements(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, nullptr));
+  } else {
+    GLCall(glDrawElementsBaseVertex(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, nullptr, base_vertex));
+  }
+}
+
+void Renderer::DrawInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader,
+                             unsigned int instance_count) const {
+  DrawInstanced(va, ib, shader, instance_count, ib.GetCount());
+}
+
+void Renderer::DrawInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader,
+                             unsigned int instance_count, unsigned int index_count, int base_vertex) const {
+  if (instance_count == 0) {
+    return;
+  }
   shader.Bind();
   va.Bind();
   ib.Bind();
+  s_stats.draw_calls++;
+  s_stats.draws++;
+
+  if (base_vertex == 0) {
+    GLCall(glDrawElementsInstanced(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, nullptr, instance_count));
+  } else {
+    GLCall(glDrawElementsInstancedBaseVertex(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, nullptr, instance_count,
+                                             base_vertex));
+  }
+}
+
+unsigned int Renderer::DrawIndirect(const VertexArray& va, const IndexBuffer& ib, const Shader& shader,
+                                   DrawIndirectBuffer& commands) const {
+  unsigned int count = commands.GetCommandCount();
+  if (count == 0) {
+    return 0;
+  }
+  shader.Bind();
+  va.Bind();
+  ib.Bind();
+  s_stats.draws += count;
+
+  if (DrawIndirectBuffer::IsIndirectSupported()) {
+    commands.Bind();
+    GLCall(glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, count, 0));
+    s_stats.draw_calls++;
+    return 1;
+  }
+
+  if (!commands.HasInstancedCommands()) {
+    GLCall(glMultiDrawElementsBaseVertex(GL_TRIANGLES, commands.GetCounts(), GL_UNSIGNED_INT,
+                                         commands.GetIndexOffsets(), count, commands.GetBaseVertices()));
+    s_stats.draw_calls++;
+    return 1;
+  }
+
+  // glMultiDrawElementsBaseVertex has no instance counts, so mixed batches go one command at a time
+  for (const DrawElementsIndirectCommand& c : commands.GetCommands()) {
+    if (c.instance_count == 0) continue;
+    const void* offset = (const void*)(uintptr_t)(c.first_index * sizeof(unsigned int));
+    GLCall(glDrawElementsInstancedBaseVertex(GL_TRIANGLES, c.count, GL_UNSIGNED_INT, offset, c.instance_count,
+                                             c.base_vertex));
+    s_stats.draw_calls++;
+  }
+  return count;
+}
+
+const Renderer::Stats& Renderer::GetStats() { return s_stats; }
+
+void Renderer::ResetStats() { s_stats = Stats(); }
+
+static void ApplyBlendMode(BlendMode mode) {
+  switch (mode) {
+    case BlendMode::kOpaque:
+      GLCall(glDisable(GL_BLEND));
+      break;
+    case BlendMode::kAlpha:
+      GLCall(glEnable(GL_BLEND));
+      GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+      break;
+    case BlendMode::kAdditive:
+      GLCall(glEnable(GL_BLEND));
+      GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE));
+      break;
+  }
+}
+
+static void ApplyUniform(Shader& shader, const RecordedUniform& uniform) {
+  switch (uniform.type) {
+    case RecordedUniform::Type::kInt:
+      shader.SetUniform1i(uniform.name, uniform.value.i);
+      break;
+    case RecordedUniform::Type::kFloat:
+      shader.SetUniform1f(uniform.name, uniform.value.f);
+      break;
+    case RecordedUniform::Type::kVec4:
+      shader.SetUniform4f(uniform.name, uniform.value.v[0], uniform.value.v[1], uniform.value.v[2],
+                          uniform.value.v[3]);
+      break;
+    case RecordedUniform::Type::kMat4:
+      shader.SetUniformMat4f(uniform.name, glm::make_mat4(uniform.value.v));
+      break;
+  }
+}
+
+void Renderer::Submit(RenderCommandBucket& bucket) const {
+  PROFILE_GPU_SCOPE("Submit");
+  bucket.Sort();
+
+  bool first = true;
+  BlendMode blend = BlendMode::kOpaque;
+  bool depth_test = false;
+  for (const RenderCommandBucket::Entry& entry : bucket) {
+    const DrawPacket& packet = *entry.packet;
+    if (first || packet.blend != blend) {
+      ApplyBlendMode(packet.blend);
+      blend = packet.blend;
+    }
+    if (first || packet.depth_test != depth_test) {
+      if (packet.depth_test) {
+        GLCall(glEnable(GL_DEPTH_TEST));
+      } else {
+        GLCall(glDisable(GL_DEPTH_TEST));
+      }
+      depth_test = packet.depth_test;
+    }
+    first = false;
+
+    // Program and texture binds are filtered by GLStateCache, which the sort order plays into
+    packet.shader->Bind();
+    for (unsigned int i = 0; i < DrawPacket::kMaxTextures && packet.textures[i]; i++) {
+      packet.textures[i]->Bind(i);
+    }
+    for (const RecordedUniform* u = packet.uniforms; u; u = u->next) {
+      ApplyUniform(*packet.shader, *u);
+    }
+
+    if (packet.instance_count == 1) {
+      Draw(*packet.vao, *packet.ib, *packet.shader);
+    } else {
+      DrawInstanced(*packet.vao, *packet.ib, *packet.shader, packet.instance_count);
+    }
+  }
 
-  GLCall(glDrawElements(GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, nullptr));
+  bucket.Reset();
 }
@@ -0,0 +1,99 @@
+#include "render_command_bucket.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include "glm/gtc/type_ptr.hpp"
+#include "shader.h"
+#include "texture.h"
+
+LinearArena::LinearArena(size_t capacity)
+    : memory_(std::make_unique<unsigned char[]>(capacity)), capacity_(capacity), offset_(0) {}
+
+void* LinearArena::Allocate(size_t size, size_t alignment) {
+  size_t offset = offset_.load(std::memory_order_relaxed);
+  size_t aligned;
+  do {
+    aligned = (offset + alignment - 1) & ~(alignment - 1);
+    if (aligned + size > capacity_) return nullptr;
+  } while (!offset_.compare_exchange_weak(offset, aligned + size, std::memory_order_relaxed));
+  return memory_.get() + aligned;
+}
+
+void LinearArena::Reset() { offset_.store(0, std::memory_order_relaxed); }
+
+RenderCommandBucket::RenderCommandBucket(size_t arena_bytes, unsigned int max_draws)
+    : arena_(arena_bytes), entries_(max_draws), draw_count_(0) {}
+
+DrawPacket* RenderCommandBucket::AddDraw(uint8_t layer, float depth) {
+  void* memory = arena_.Allocate(sizeof(DrawPacket), alignof(DrawPacket));
+  if (!memory) return nullptr;
+
+  unsigned int index = draw_count_.fetch_add(1, std::memory_order_relaxed);
+  if (index >= entries_.size()) return nullptr;
+
+  DrawPacket* packet = new (memory) DrawPacket();
+  packet->layer = layer;
+  packet->depth = depth;
+  entries_[index] = {0, packet};
+  return packet;
+}
+
+RecordedUniform* RenderCommandBucket::AddUniform(DrawPacket* packet, UniformHandle name,
+                                                 RecordedUniform::Type type) {
+  void* memory = arena_.Allocate(sizeof(RecordedUniform), alignof(RecordedUniform));
+  if (!memory) return nullptr;
+
+  RecordedUniform* uniform = new (memory) RecordedUniform{name, type, nullptr, {}};
+
+  // Appended, so a uniform recorded twice ends up with the later value
+  RecordedUniform** tail = &packet->uniforms;
+  while (*tail) tail = &(*tail)->next;
+  *tail = uniform;
+  return uniform;
+}
+
+void RenderCommandBucket::SetUniform1i(DrawPacket* packet, UniformHandle name, int value) {
+  if (RecordedUniform* u = AddUniform(packet, name, RecordedUniform::Type::kInt)) u->value.i = value;
+}
+
+void RenderCommandBucket::SetUniform1f(DrawPacket* packet, UniformHandle name, float value) {
+  if (RecordedUniform* u = AddUniform(packet, name, RecordedUniform::Type::kFloat)) u->value.f = value;
+}
+
+void RenderCommandBucket::SetUniform4f(DrawPacket* packet, UniformHandle name, const glm::vec4& value) {
+  if (RecordedUniform* u = AddUniform(packet, name, RecordedUniform::Type::kVec4)) {
+    memcpy(u->value.v, glm::value_ptr(value), sizeof(value));
+  }
+}
+
+void RenderCommandBucket::SetUniformMat4f(DrawPacket* packet, UniformHandle name, const glm::mat4& value) {
+  if (RecordedUniform* u = AddUniform(packet, name, RecordedUniform::Type::kMat4)) {
+    memcpy(u->value.v, glm::value_ptr(value), sizeof(value));
+  }
+}
+
+unsigned int RenderCommandBucket::GetDrawCount() const {
+  return std::min<unsigned int>(draw_count_.load(std::memory_order_relaxed), entries_.size());
+}
+
+uint64_t RenderCommandBucket::MakeKey(const DrawPacket& packet) {
+  uint64_t program = packet.shader ? packet.shader->GetRendererID() & 0xffff : 0;
+  uint64_t texture = packet.textures[0] ? packet.textures[0]->GetRendererID() & 0xffff : 0;
+  uint64_t depth = (uint64_t)(std::clamp(packet.depth, 0.0f, 1.0f) * 0xffffff);
+  return (uint64_t)packet.layer << 56 | program << 40 | texture << 24 | depth;
+}
+
+void RenderCommandBucket::Sort() {
+  Entry* first = entries_.data();
+  Entry* last = first + GetDrawCount();
+  for (Entry* e = first; e != last; e++) {
+    e->key = MakeKey(*e->packet);
+  }
+  // Stable, so packets with equal keys keep their recording order
+  std::stable_sort(first, last, [](const Entry& a, const Entry& b) { return a.key < b.key; });
+}
+
+void RenderCommandBucket::Reset() {
+  draw_count_.store(0, std::memory_order_relaxed);
+  arena_.Reset();
+}
@@ -0,0 +1,65 @@
+#include "sampler.h"
+#include <algorithm>
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
+#include "renderer.h"
+
+Sampler::Sampler(TextureFilter filter, TextureWrap wrap, float anisotropy)
+    : renderer_id_(0), filter_(filter), wrap_(wrap), anisotropy_(1.0f) {
+  GLCall(glGenSamplers(1, &renderer_id_));
+  SetFilter(filter);
+  SetWrap(wrap);
+  SetAnisotropy(anisotropy);
+}
+
+Sampler::~Sampler() {
+  GLCall(glDeleteSamplers(1, &renderer_id_));
+  GLStateCache::Get().OnDeleteSampler(renderer_id_);
+}
+
+void Sampler::Bind(unsigned int unit) const { GLStateCache::Get().BindSampler(unit, renderer_id_); }
+
+void Sampler::Unbind(unsigned int unit) { GLStateCache::Get().BindSampler(unit, 0); }
+
+void Sampler::SetFilter(TextureFilter filter) {
+  filter_ = filter;
+  int min_filter = GL_LINEAR, mag_filter = GL_LINEAR;
+  switch (filter) {
+    case TextureFilter::kNearest:
+      min_filter = mag_filter = GL_NEAREST;
+      break;
+    case TextureFilter::kLinear:
+      break;
+    case TextureFilter::kTrilinear:
+      min_filter = GL_LINEAR_MIPMAP_LINEAR;
+      break;
+  }
+  GLCall(glSamplerParameteri(renderer_id_, GL_TEXTURE_MIN_FILTER, min_filter));
+  GLCall(glSamplerParameteri(renderer_id_, GL_TEXTURE_MAG_FILTER, mag_filter));
+}
+
+void Sampler::SetWrap(TextureWrap wrap) {
+  wrap_ = wrap;
+  int mode = GL_CLAMP_TO_EDGE;
+  if (wrap == TextureWrap::kRepeat) mode = GL_REPEAT;
+  if (wrap == TextureWrap::kMirror) mode = GL_MIRRORED_REPEAT;
+  GLCall(glSamplerParameteri(renderer_id_, GL_TEXTURE_WRAP_S, mode));
+  GLCall(glSamplerParameteri(renderer_id_, GL_TEXTURE_WRAP_T, mode));
+}
+
+void Sampler::SetAnisotropy(float anisotropy) {
+  anisotropy_ = std::clamp(anisotropy, 1.0f, GetMaxAnisotropy());
+  if (GLAD_GL_EXT_texture_filter_anisotropic) {
+    GLCall(glSamplerParameterf(renderer_id_, GL_TEXTURE_MAX_ANISOTROPY, anisotropy_));
+  }
+}
+
+float Sampler::GetMaxAnisotropy() {
+  if (!GLAD_GL_EXT_texture_filter_anisotropic) return 1.0f;
+  static float max_anisotropy = 0.0f;
+  if (max_anisotropy == 0.0f) {
+    GLCall(glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &max_anisotropy));
+    max_anisotropy = std::max(max_anisotropy, 1.0f);
+  }
+  return max_anisotropy;
+}
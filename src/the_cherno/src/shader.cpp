@@ -1,34 +1,118 @@
 #include "shader.h"
 #include <fstream>
 #include <sstream>
+#include <vector>
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
 #include "glm/gtc/type_ptr.hpp"
+#include "program_binary_cache.h"
 #include "renderer.h"
 
-Shader::Shader(const std::string& filepath) : file_path_(filepath) {
+Shader::Shader(const std::string& filepath, const std::vector<std::string>& defines, CompileMode mode)
+    : file_path_(filepath),
+      state_(State::kPending),
+      pending_vs_(0),
+      pending_fs_(0),
+      cache_key_(0),
+      uniform_location_count_(0) {
   ShaderProgramSource source = ParseShader(filepath);
-  renderer_id_ = CreateShader(source.VertexSource, source.FragmentSource);
+  source.VertexSource = InjectDefines(source.VertexSource, defines);
+  source.FragmentSource = InjectDefines(source.FragmentSource, defines);
+
+  ProgramBinaryCache& cache = ProgramBinaryCache::Get();
+  cache_key_ = cache.MakeKey(source);
+  renderer_id_ = cache.Load(cache_key_);
+  if (renderer_id_ == 0) {
+    renderer_id_ = CreateShader(source.VertexSource, source.FragmentSource);
+    if (mode == CompileMode::kDeferred) return;
+  }
+  Finish();
+}
+
+Shader::~Shader() {
+  if (pending_vs_) GLCall(glDeleteShader(pending_vs_));
+  if (pending_fs_) GLCall(glDeleteShader(pending_fs_));
+  GLCall(glDeleteProgram(renderer_id_));
+  GLStateCache::Get().OnDeleteProgram(renderer_id_);
 }
 
-Shader::~Shader() { GLCall(glDeleteProgram(renderer_id_)); }
+bool Shader::Poll() {
+  if (state_ != State::kPending) return true;
 
-void Shader::Bind() const { GLCall(glUseProgram(renderer_id_)); }
+  if (GLAD_GL_KHR_parallel_shader_compile) {
+    int complete = GL_FALSE;
+    GLCall(glGetProgramiv(renderer_id_, GL_COMPLETION_STATUS_KHR, &complete));
+    if (complete == GL_FALSE) return false;
+  }
+  Finish();
+  return true;
+}
 
-void Shader::Unbind() const { GLCall(glUseProgram(0)); }
+void Shader::Bind() const { GLStateCache::Get().UseProgram(renderer_id_); }
 
-void Shader::SetUniform4f(const std::string& name, float v0, float v1, float v2, float v3) {
+void Shader::Unbind() const { GLStateCache::Get().UseProgram(0); }
+
+void Shader::SetUniform4f(UniformHandle name, float v0, float v1, float v2, float v3) {
   GLCall(glUniform4f(GetUniformLocation(name), v0, v1, v2, v3));
 }
 
-void Shader::SetUniform1i(const std::string& name, int value) { GLCall(glUniform1i(GetUniformLocation(name), value)); }
+void Shader::SetUniform1i(UniformHandle name, int value) { GLCall(glUniform1i(GetUniformLocation(name), value)); }
 
-void Shader::SetUniform1f(const std::string& name, float value) {
+void Shader::SetUniform1iv(UniformHandle name, int count, const int* values) {
+  GLCall(glUniform1iv(GetUniformLocation(name), count, values));
+}
+
+void Shader::SetUniform1f(UniformHandle name, float value) {
   GLCall(glUniform1f(GetUniformLocation(name), value));
 }
 
-void Shader::SetUniformMat4f(const std::string& name, const glm::mat4& matrix) {
+void Shader::SetUniformMat4f(UniformHandle name, const glm::mat4& matrix) {
   GLCall(glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(matrix)));
 }
 
+bool Shader::HasUniformBlock(const std::string& block) const {
+  unsigned int index;
+  GLCall(index = glGetUniformBlockIndex(renderer_id_, block.c_str()));
+  return index != GL_INVALID_INDEX;
+}
+
+void Shader::BindUniformBlock(const std::string& block, unsigned int binding) {
+  unsigned int index;
+  GLCall(index = glGetUniformBlockIndex(renderer_id_, block.c_str()));
+  if (index == GL_INVALID_INDEX) {
+    std::cout << "Warning: uniform block '" << block << "' doesn't exist" << std::endl;
+    return;
+  }
+  GLCall(glUniformBlockBinding(renderer_id_, index, binding));
+}
+
+UniformBlockLayout Shader::GetUniformBlockLayout(const std::string& block) const {
+  UniformBlockLayout layout;
+  layout.name = block;
+
+  unsigned int index;
+  GLCall(index = glGetUniformBlockIndex(renderer_id_, block.c_str()));
+  if (index == GL_INVALID_INDEX) return layout;
+
+  int size = 0, member_count = 0;
+  GLCall(glGetActiveUniformBlockiv(renderer_id_, index, GL_UNIFORM_BLOCK_DATA_SIZE, &size));
+  GLCall(glGetActiveUniformBlockiv(renderer_id_, index, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &member_count));
+  layout.size = size;
+
+  std::vector<int> indices(member_count);
+  GLCall(glGetActiveUniformBlockiv(renderer_id_, index, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, indices.data()));
+  std::vector<unsigned int> members(indices.begin(), indices.end());
+  std::vector<int> offsets(member_count);
+  GLCall(glGetActiveUniformsiv(renderer_id_, member_count, members.data(), GL_UNIFORM_OFFSET, offsets.data()));
+
+  for (int i = 0; i < member_count; i++) {
+    char name[128];
+    GLCall(glGetActiveUniformName(renderer_id_, members[i], sizeof(name), nullptr, name));
+    layout.offsets[name] = offsets[i];
+  }
+  return layout;
+}
+
 ShaderProgramSource Shader::ParseShader(const std::string& filepath) {
   std::ifstream stream(filepath);
   enum class ShaderType { kNone = -1, kVertex = 0, kFragment = 1 };
@@ -52,14 +136,34 @@ ShaderProgramSource Shader::ParseShader(const std::string& filepath) {
   return {ss[0].str(), ss[1].str()};
 }
 
+std::string Shader::InjectDefines(const std::string& source, const std::vector<std::string>& defines) {
+  if (defines.empty()) return source;
+
+  std::string block;
+  for (const std::string& define : defines) block += "#define " + define + "\n";
+
+  // #version must stay the first statement
+  size_t insert = 0;
+  size_t version = source.find("#version");
+  if (version != std::string::npos) {
+    size_t line_end = source.find('\n', version);
+    insert = line_end == std::string::npos ? source.size() : line_end + 1;
+  }
+  std::string result = source;
+  result.insert(insert, block);
+  return result;
+}
+
 unsigned int Shader::CompileShader(unsigned int type, const std::string& source) {
   unsigned id;
   GLCall(id = glCreateShader(type));
   const char* src = source.c_str();
   GLCall(glShaderSource(id, 1, &src, nullptr));
   GLCall(glCompileShader(id));
+  return id;
+}
 
-  // Error handling
+bool Shader::CheckCompileStatus(unsigned int id, unsigned int type) {
   int result;
   GLCall(glGetShaderiv(id, GL_COMPILE_STATUS, &result));
   if (result == GL_FALSE) {
@@ -67,39 +171,137 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
     GLCall(glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length));
     char* message = (char*)alloca(length * sizeof(char));
     GLCall(glGetShaderInfoLog(id, length, &length, message));
-    std::cout << "Failed to compile " << (type == (unsigned int)GL_VERTEX_SHADER ? "vertex" : "fragment") << std::endl;
+    std::cout << "Failed to compile " << (type == (unsigned int)GL_VERTEX_SHADER ? "vertex" : "fragment") << " ("
+              << file_path_ << ")" << std::endl;
     std::cout << message << std::endl;
-    GLCall(glDeleteShader(id));
-    return 0;
+    return false;
   }
-
-  return id;
+  return true;
 }
 
 unsigned int Shader::CreateShader(const std::string& vertex_shader, const std::string& fragment_shader) {
-  unsigned int program = glCreateProgram();
-  unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertex_shader);
-  unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragment_shader);
+  unsigned int program;
+  GLCall(program = glCreateProgram());
+  pending_vs_ = CompileShader(GL_VERTEX_SHADER, vertex_shader);
+  pending_fs_ = CompileShader(GL_FRAGMENT_SHADER, fragment_shader);
 
-  GLCall(glAttachShader(program, vs));
-  GLCall(glAttachShader(program, fs));
+  GLCall(glAttachShader(program, pending_vs_));
+  GLCall(glAttachShader(program, pending_fs_));
+  if (GLAD_GL_ARB_get_program_binary) {
+    GLCall(glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+  }
   GLCall(glLinkProgram(program));
-  GLCall(glValidateProgram(program));
-
-  GLCall(glDeleteShader(vs));
-  GLCall(glDeleteShader(fs));
   return program;
 }
 
-int Shader::GetUniformLocation(const std::string& name) const {
-  if (uniform_location_cache_.find(name) != uniform_location_cache_.end()) {
-    return uniform_location_cache_[name];
+void Shader::Finish() {
+  bool from_source = pending_vs_ != 0;
+  bool ok = true;
+  if (from_source) {
+    ok = CheckCompileStatus(pending_vs_, GL_VERTEX_SHADER) && ok;
+    ok = CheckCompileStatus(pending_fs_, GL_FRAGMENT_SHADER) && ok;
+
+    int linked;
+    GLCall(glGetProgramiv(renderer_id_, GL_LINK_STATUS, &linked));
+    if (ok && linked == GL_FALSE) {
+      int length;
+      GLCall(glGetProgramiv(renderer_id_, GL_INFO_LOG_LENGTH, &length));
+      char* message = (char*)alloca(length * sizeof(char));
+      GLCall(glGetProgramInfoLog(renderer_id_, length, &length, message));
+      std::cout << "Failed to link " << file_path_ << std::endl;
+      std::cout << message << std::endl;
+      ok = false;
+    }
+
+    GLCall(glDetachShader(renderer_id_, pending_vs_));
+    GLCall(glDetachShader(renderer_id_, pending_fs_));
+    GLCall(glDeleteShader(pending_vs_));
+    GLCall(glDeleteShader(pending_fs_));
+    pending_vs_ = pending_fs_ = 0;
   }
-  int location;
-  GLCall(location = glGetUniformLocation(renderer_id_, name.c_str()));
-  if (location == -1) {
-    std::cout << "Warning: uniform '" << name << "' doesn't exits" << std::endl;
+
+  if (!ok) {
+    state_ = State::kFailed;
+    return;
   }
-  uniform_location_cache_[name] = location;
-  return location;
+  if (from_source) ProgramBinaryCache::Get().Store(cache_key_, renderer_id_);
+
+  BuildUniformLocations();
+  if (HasUniformBlock(kCameraBlockName)) BindUniformBlock(kCameraBlockName, kCameraBlockBinding);
+  state_ = State::kReady;
+}
+
+void Shader::BuildUniformLocations() {
+  int count = 0, max_length = 0;
+  GLCall(glGetProgramiv(renderer_id_, GL_ACTIVE_UNIFORMS, &count));
+  GLCall(glGetProgramiv(renderer_id_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length));
+
+  unsigned int capacity = 16;
+  while (capacity < (unsigned int)count * 4) capacity *= 2;
+  uniform_locations_.assign(capacity, {0, -1});
+  uniform_location_count_ = 0;
+
+  std::vector<char> buffer(max_length + 1);
+  for (int i = 0; i < count; i++) {
+    int size = 0, length = 0;
+    unsigned int type;
+    GLCall(glGetActiveUniform(renderer_id_, i, buffer.size(), &length, &size, &type, buffer.data()));
+    std::string name(buffer.data(), length);
+
+    int location;
+    GLCall(location = glGetUniformLocation(renderer_id_, name.c_str()));
+    if (location == -1) continue;  // uniform block member
+
+    // Arrays are reported as "name[0]"; register "name" and every "name[i]"
+    size_t bracket = name.find('[');
+    if (bracket == std::string::npos) {
+      InsertUniformLocation(HashUniformName(name), location);
+      continue;
+    }
+    std::string base = name.substr(0, bracket);
+    InsertUniformLocation(HashUniformName(base), location);
+    for (int e = 0; e < size; e++) {
+      std::string element = base + "[" + std::to_string(e) + "]";
+      GLCall(location = glGetUniformLocation(renderer_id_, element.c_str()));
+      InsertUniformLocation(HashUniformName(element), location);
+    }
+  }
+}
+
+void Shader::InsertUniformLocation(uint32_t hash, int location) const {
+  if ((uniform_location_count_ + 1) * 2 > uniform_locations_.size()) {
+    std::vector<UniformSlot> old = std::move(uniform_locations_);
+    uniform_locations_.assign(old.size() * 2, {0, -1});
+    uniform_location_count_ = 0;
+    for (const UniformSlot& slot : old) {
+      if (slot.hash) InsertUniformLocation(slot.hash, slot.location);
+    }
+  }
+
+  size_t mask = uniform_locations_.size() - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    UniformSlot& slot = uniform_locations_[i];
+    if (slot.hash == hash) {
+      std::cout << "Warning: uniform name hash collision in " << file_path_ << std::endl;
+      return;
+    }
+    if (slot.hash == 0) {
+      slot = {hash, location};
+      uniform_location_count_++;
+      return;
+    }
+  }
+}
+
+int Shader::GetUniformLocation(UniformHandle name) const {
+  size_t mask = uniform_locations_.size() - 1;
+  for (size_t i = name.GetHash() & mask;; i = (i + 1) & mask) {
+    const UniformSlot& slot = uniform_locations_[i];
+    if (slot.hash == name.GetHash()) return slot.location;
+    if (slot.hash == 0) break;
+  }
+
+  std::cout << "Warning: uniform '" << name.GetName() << "' doesn't exits" << std::endl;
+  InsertUniformLocation(name.GetHash(), -1);
+  return -1;
 }
@@ -0,0 +1,78 @@
+#include "shader_library.h"
+#include "gl_extensions.h"
+#include "glm/glm.hpp"
+#include "profiler.h"
+#include "renderer.h"
+
+ShaderLibrary& ShaderLibrary::Get() {
+  static ShaderLibrary library;
+  return library;
+}
+
+ShaderLibrary::ShaderLibrary() {}
+
+void ShaderLibrary::Load(const std::string& name, const std::string& filepath, const std::vector<std::string>& defines,
+                         ReadyCallback on_ready) {
+  auto it = entries_.find(name);
+  if (it == entries_.end()) {
+    // Let the driver compile on as many threads as it likes; only needs to happen once per context
+    if (entries_.empty() && GLAD_GL_KHR_parallel_shader_compile) {
+      GLCall(glMaxShaderCompilerThreadsKHR(0xffffffff));
+    }
+    Entry entry;
+    entry.shader = std::make_unique<Shader>(filepath, defines, Shader::CompileMode::kDeferred);
+    it = entries_.emplace(name, std::move(entry)).first;
+  }
+
+  Entry& entry = it->second;
+  if (on_ready) entry.on_ready.push_back(std::move(on_ready));
+  if (entry.shader->IsReady()) NotifyReady(*entry.shader, entry.on_ready);
+}
+
+void ShaderLibrary::Update() {
+  PROFILE_SCOPE("Shader polling");
+  for (auto& [name, entry] : entries_) {
+    if (entry.shader->IsReady() || entry.shader->IsFailed()) continue;
+    if (entry.shader->Poll() && entry.shader->IsReady()) NotifyReady(*entry.shader, entry.on_ready);
+  }
+}
+
+size_t ShaderLibrary::GetPendingCount() const {
+  size_t pending = 0;
+  for (const auto& [name, entry] : entries_) {
+    if (!entry.shader->IsReady() && !entry.shader->IsFailed()) pending++;
+  }
+  return pending;
+}
+
+bool ShaderLibrary::IsReady(const std::string& name) const {
+  auto it = entries_.find(name);
+  return it != entries_.end() && it->second.shader->IsReady();
+}
+
+Shader& ShaderLibrary::Get(const std::string& name) {
+  auto it = entries_.find(name);
+  if (it != entries_.end() && it->second.shader->IsReady()) return *it->second.shader;
+  return GetFallback();
+}
+
+Shader& ShaderLibrary::GetFallback() {
+  if (!fallback_) {
+    fallback_ = std::make_unique<Shader>("assets/shaders/fallback.shader");
+    fallback_->Bind();
+    fallback_->SetUniformMat4f("u_model", glm::mat4(1.0f));
+  }
+  return *fallback_;
+}
+
+void ShaderLibrary::Clear() {
+  entries_.clear();
+  fallback_.reset();
+}
+
+void ShaderLibrary::NotifyReady(Shader& shader, std::vector<ReadyCallback>& callbacks) {
+  if (callbacks.empty()) return;
+  shader.Bind();
+  for (ReadyCallback& callback : callbacks) callback(shader);
+  callbacks.clear();
+}
@@ -1,5 +1,10 @@
 #include "test.h"
 #include "imgui.h"
+#include "test_batch_render.h"
+#include "test_clear_color.h"
+#include "test_instancing.h"
+#include "test_multi_draw.h"
+#include "test_texture2d.h"
 
 namespace test {
 TestMenu::TestMenu(Test*& current_test) : current_test_(current_test) {}
@@ -11,4 +16,12 @@ void TestMenu::OnImGuiRender() {
     }
   }
 }
+
+void RegisterTests(TestMenu& menu) {
+  menu.RegisterTest<TestClearColor>("Clear Color");
+  menu.RegisterTest<TestTexture2D>("2D Texture");
+  menu.RegisterTest<TestBatchRender>("Batch Render");
+  menu.RegisterTest<TestInstancing>("Instancing");
+  menu.RegisterTest<TestMultiDraw>("Multi Draw");
+}
 }  // namespace test
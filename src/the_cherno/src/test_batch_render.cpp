@@ -2,36 +2,84 @@
 
 #include "imgui.h"
 #include "renderer.h"
+#include "texture_loader.h"
 
+#include <cmath>
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
-#include "vertex_buffer_layout.h"
 
 namespace test {
 TestBatchRender::TestBatchRender()
     : proj_(glm::ortho(0.0f, 640.0f, 0.0f, 480.0f, -1.0f, 1.0f)),
-      view_(glm::translate(glm::mat4(1.0f), glm::vec3(-100, 0, 0))),
-      translation_(glm::vec3(0, 0, 0)) {
-  float positions[] = {
-      100.0f, 100.0f, 200.0f, 100.0f, 200.0f, 200.0f, 100.0f, 200.0f,
-
-      300.0f, 100.0f, 400.0f, 100.0f, 400.0f, 200.0f, 300.0f, 200.0f,
-
-  };
-
-  unsigned int indices[] = {0, 1, 2, 2, 3, 0, 4, 5, 6, 6, 7, 4};
-
-  vao_ = std::make_unique<VertexArray>();
-
-  vertex_buffer_ = std::make_unique<VertexBuffer>(positions, 8 * 2 * sizeof(float));
-  VertexBufferLayout layout;
-  layout.Push<float>(2);
-  vao_->AddBuffer(*vertex_buffer_, layout);
+      view_(glm::translate(glm::mat4(1.0f), glm::vec3(0, 0, 0))),
+      translation_(glm::vec3(0, 0, 0)),
+      quad_count_(10000),
+      textured_(true),
+      use_atlas_(true),
+      tile_source_(kTileImage),
+      bindless_(false),
+      mipmaps_(true),
+      anisotropy_(1.0f),
+      sprite_seed_(0) {
+  GLCall(glEnable(GL_BLEND));
+  GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+
+  batch_renderer_ = std::make_unique<BatchRenderer2D>();
+  texture_ = TextureLoader::Get().Load("assets/textures/cat.jpg", MipmapMode::kCpu);
+  sampler_ = std::make_unique<Sampler>(TextureFilter::kTrilinear, TextureWrap::kClamp, anisotropy_);
+  batch_renderer_->SetSampler(sampler_.get());
+
+  atlas_ = std::make_unique<TextureAtlas>(512, 512, 4);
+  for (int i = 0; i < 64; i++) InsertSprite();
+  CreateTiles();
+}
 
-  index_buffer_ = std::make_unique<IndexBuffer>(indices, 12);
+// 64 small checkerboards, once as separate textures and once as the layers of one array, to compare a
+// batch that runs out of texture slots with one that doesn't
+void TestBatchRender::CreateTiles() {
+  constexpr int kTileCount = 64;
+  constexpr int kTileSize = 16;
+  tile_array_ = std::make_unique<TextureArray>(kTileSize, kTileSize, kTileCount, MipmapMode::kCpu);
+
+  std::vector<unsigned char> pixels(kTileSize * kTileSize * 4);
+  for (int i = 0; i < kTileCount; i++) {
+    unsigned int seed = (i + 1) * 2246822519u;
+    for (int y = 0; y < kTileSize; y++) {
+      for (int x = 0; x < kTileSize; x++) {
+        bool dark = ((x / 4) + (y / 4)) % 2 == 0;
+        unsigned char* p = &pixels[(y * kTileSize + x) * 4];
+        p[0] = (unsigned char)((seed >> 8 & 0xff) >> (dark ? 1 : 0));
+        p[1] = (unsigned char)((seed >> 16 & 0xff) >> (dark ? 1 : 0));
+        p[2] = (unsigned char)((seed >> 24 & 0xff) >> (dark ? 1 : 0));
+        p[3] = 0xff;
+      }
+    }
+    tiles_.push_back(std::make_unique<Texture>(kTileSize, kTileSize, pixels.data(), MipmapMode::kCpu));
+    tile_array_->SetLayer(i, pixels.data());
+  }
+}
 
-  shader_ = std::make_unique<Shader>("assets/shaders/batch.shader");
-  shader_->Bind();
+// A procedural sprite: a ring of random size and color, so the atlas has something varied to pack
+void TestBatchRender::InsertSprite() {
+  unsigned int seed = sprite_seed_++ * 2654435761u;
+  int size = 16 + seed % 49;
+  glm::vec3 color((seed >> 8 & 0xff) / 255.0f, (seed >> 16 & 0xff) / 255.0f, (seed >> 24 & 0xff) / 255.0f);
+
+  std::vector<unsigned char> pixels((size_t)size * size * 4);
+  float radius = size * 0.5f;
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      float distance = glm::length(glm::vec2(x + 0.5f, y + 0.5f) - glm::vec2(radius));
+      float ring = glm::clamp(1.0f - std::abs(distance - radius * 0.7f) / (radius * 0.3f), 0.0f, 1.0f);
+      unsigned char* p = &pixels[((size_t)y * size + x) * 4];
+      p[0] = (unsigned char)(color.r * 255.0f);
+      p[1] = (unsigned char)(color.g * 255.0f);
+      p[2] = (unsigned char)(color.b * 255.0f);
+      p[3] = (unsigned char)(ring * 255.0f);
+    }
+  }
+  TextureAtlas::Handle handle = atlas_->Insert(size, size, pixels.data());
+  if (handle != TextureAtlas::kInvalidHandle) sprites_.push_back(handle);
 }
 
 TestBatchRender::~TestBatchRender() {}
@@ -42,17 +90,87 @@ void TestBatchRender::OnRender() {
   GLCall(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
   GLCall(glClear(GL_COLOR_BUFFER_BIT));
 
-  Renderer renderer;
-  glm::mat4 mvp = proj_ * view_;
-
-  shader_->Bind();
-  shader_->SetUniformMat4f("u_mvp", mvp);
-
-  renderer.Draw(*vao_, *index_buffer_, *shader_);
+  if (!camera_) {
+    camera_ = std::make_unique<UniformBuffer>(batch_renderer_->GetShader().GetUniformBlockLayout(kCameraBlockName),
+                                              kCameraBlockBinding);
+  }
+  glm::mat4 model = glm::translate(glm::mat4(1.0f), translation_);
+  camera_->SetMat4f("u_view_proj", proj_ * view_ * model);
+  camera_->Upload();
+  camera_->Bind();
+
+  // Lay the quads out on a square grid that covers the viewport
+  int columns = (int)std::ceil(std::sqrt((float)quad_count_));
+  glm::vec2 cell(640.0f / columns, 480.0f / columns);
+  glm::vec2 size = cell * 0.9f;
+
+  // The atlas shares the array slot with the tile array, mixing the two would flush every quad
+  bool atlas_sprites = use_atlas_ && !sprites_.empty() && tile_source_ != kTileArray;
+
+  // Textured cells need texture slots and go one by one; the rest are culled and written on the job system.
+  // Cells don't overlap, so drawing them in two passes looks the same
+  batch_renderer_->ResetStats();
+  batch_renderer_->BeginBatch();
+  quads_.clear();
+  for (int i = 0; i < quad_count_; i++) {
+    int x = i % columns;
+    int y = i / columns;
+    glm::vec2 position(x * cell.x, y * cell.y);
+    if (textured_ && (x + y) % 2 == 0) {
+      if (tile_source_ == kTileTextures) {
+        batch_renderer_->SubmitQuad(position, size, *tiles_[i % tiles_.size()]);
+      } else if (tile_source_ == kTileArray) {
+        batch_renderer_->SubmitQuad(position, size, *tile_array_, i % tile_array_->GetLayerCount());
+      } else {
+        batch_renderer_->SubmitQuad(position, size, *texture_);
+      }
+    } else if (atlas_sprites) {
+      quads_.push_back({position, size, glm::vec4(1.0f), sprites_[i % sprites_.size()]});
+    } else {
+      glm::vec4 color((float)x / columns, (float)y / columns, 0.8f, 1.0f);
+      quads_.push_back({position, size, color});
+    }
+  }
+  // The model matrix only translates, so the view in the quads' space is the viewport moved back
+  glm::vec2 view_min(-translation_.x, -translation_.y);
+  batch_renderer_->SubmitQuads(quads_.data(), quads_.size(), view_min, view_min + glm::vec2(640.0f, 480.0f),
+                               atlas_sprites ? atlas_.get() : nullptr);
+  batch_renderer_->EndBatch();
 }
 
 void TestBatchRender::OnImGuiRender() {
-  ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate,
-              ImGui::GetIO().Framerate);
+  ImGui::SliderFloat3("translation_", &translation_.x, -640.0f, 640.0f);
+  ImGui::SliderInt("quads", &quad_count_, 1, 100000);
+  ImGui::Checkbox("textured", &textured_);
+  ImGui::SameLine();
+  ImGui::RadioButton("image", &tile_source_, kTileImage);
+  ImGui::SameLine();
+  ImGui::RadioButton("64 textures", &tile_source_, kTileTextures);
+  ImGui::SameLine();
+  ImGui::RadioButton("texture array", &tile_source_, kTileArray);
+  if (BatchRenderer2D::IsBindlessSupported()) {
+    if (ImGui::Checkbox("bindless", &bindless_)) batch_renderer_->SetBindless(bindless_);
+  } else {
+    ImGui::TextDisabled("bindless textures not supported");
+  }
+  ImGui::Checkbox("atlas sprites", &use_atlas_);
+  if (ImGui::Button("churn atlas")) {
+    // Evict the oldest half and insert as many new sprites, reusing the freed space
+    size_t count = sprites_.size() / 2;
+    for (size_t i = 0; i < count; i++) atlas_->Remove(sprites_[i]);
+    sprites_.erase(sprites_.begin(), sprites_.begin() + count);
+    for (size_t i = 0; i < count; i++) InsertSprite();
+  }
+  ImGui::SameLine();
+  ImGui::Text("%zu sprites, %u layers", atlas_->GetImageCount(), atlas_->GetLayerCount());
+  if (ImGui::Checkbox("mipmaps", &mipmaps_)) {
+    sampler_->SetFilter(mipmaps_ ? TextureFilter::kTrilinear : TextureFilter::kLinear);
+  }
+  if (ImGui::SliderFloat("anisotropy", &anisotropy_, 1.0f, Sampler::GetMaxAnisotropy())) {
+    sampler_->SetAnisotropy(anisotropy_);
+  }
+
+  const BatchRenderer2D::Stats& stats = batch_renderer_->GetStats();
+  ImGui::Text("Draw calls: %u, quads: %u, culled: %u", stats.draw_calls, stats.quad_count, stats.culled_count);
 }
 }  // namespace test
@@ -0,0 +1,125 @@
+#include "test_instancing.h"
+#include <algorithm>
+#include <cmath>
+#include "frame_packet.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include "imgui.h"
+#include "job_system.h"
+#include "renderer.h"
+#include "shader_library.h"
+#include "texture_loader.h"
+#include "trace_recorder.h"
+#include "vertex_buffer_layout.h"
+
+namespace test {
+// Instances per job; a matrix is a few dozen nanoseconds
+static constexpr size_t kTransformGrain = 1024;
+
+TestInstancing::TestInstancing()
+    : proj_(glm::ortho(0.0f, 960.0f, 0.0f, 720.0f, -1.0f, 1.0f)),
+      instance_count_(10000),
+      animate_(false),
+      dirty_(true),
+      previous_angle_(0.0f),
+      angle_(0.0f),
+      render_angle_(0.0f) {
+  // Unit quad centred on the origin, so instances rotate about their own centre
+  float positions[] = {
+      -0.5f, -0.5f, 0.0f, 0.0f,  // 0
+      0.5f,  -0.5f, 1.0f, 0.0f,  // 1
+      0.5f,  0.5f,  1.0f, 1.0f,  // 2
+      -0.5f, 0.5f,  0.0f, 1.0f   // 3
+  };
+  unsigned int indices[] = {0, 1, 2, 2, 3, 0};
+
+  vao_ = std::make_unique<VertexArray>();
+
+  vertex_buffer_ = std::make_unique<VertexBuffer>(positions, sizeof(positions));
+  VertexBufferLayout layout;
+  layout.Push<float>(2);
+  layout.Push<float>(2);
+  vao_->AddBuffer(*vertex_buffer_, layout);
+
+  instance_buffer_ = std::make_unique<VertexBuffer>(kMaxInstances * sizeof(Instance));
+  VertexBufferLayout instance_layout(1);
+  instance_layout.Push<glm::mat4>(1);
+  instance_layout.Push<float>(4);
+  vao_->AddBuffer(*instance_buffer_, instance_layout);
+
+  index_buffer_ = std::make_unique<IndexBuffer>(indices, 6);
+
+  ShaderLibrary::Get().Load("instanced", "assets/shaders/instanced.shader", {},
+                            [](Shader& shader) { shader.SetUniform1i("u_texture", 0); });
+
+  texture_ = TextureLoader::Get().Load("assets/textures/cat.jpg");
+}
+
+TestInstancing::~TestInstancing() {}
+
+void TestInstancing::BuildInstances(Instance* instances) const {
+  // Square-ish grid that fills the viewport
+  int columns = (int)std::ceil(std::sqrt(instance_count_ * 960.0f / 720.0f));
+  int rows = (instance_count_ + columns - 1) / columns;
+  glm::vec2 cell(960.0f / columns, 720.0f / rows);
+  float size = std::min(cell.x, cell.y) * 0.8f;
+
+  // Every instance is independent, so the grid is split over the job system
+  JobSystem::Get().ParallelFor(instance_count_, kTransformGrain, [&](size_t begin, size_t end) {
+    TRACE_SCOPE("Transform job");
+    for (int i = (int)begin; i < (int)end; i++) {
+      int x = i % columns, y = i / columns;
+      glm::vec3 center((x + 0.5f) * cell.x, (y + 0.5f) * cell.y, 0.0f);
+      float spin = render_angle_ + (x + y) * 0.1f;
+
+      glm::mat4 model = glm::translate(glm::mat4(1.0f), center);
+      model = glm::rotate(model, spin, glm::vec3(0.0f, 0.0f, 1.0f));
+      instances[i].model = glm::scale(model, glm::vec3(size, size, 1.0f));
+      instances[i].color = glm::vec4((float)x / columns, (float)y / rows, 1.0f, 1.0f);
+    }
+  });
+}
+
+void TestInstancing::OnFixedUpdate(float step) {
+  // Also while paused, so the interpolation settles on angle_ instead of wobbling a step behind it
+  previous_angle_ = angle_;
+  if (animate_) angle_ += step;
+}
+
+void TestInstancing::OnUpdate(float deltaTime) {}
+
+void TestInstancing::OnInterpolate(float alpha) {
+  float angle = glm::mix(previous_angle_, angle_, alpha);
+  if (angle != render_angle_) {
+    render_angle_ = angle;
+    dirty_ = true;
+  }
+}
+
+void TestInstancing::OnExtract(FramePacket& packet) {
+  packet.SetClearColor(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+  packet.SetViewProjection(proj_);
+
+  // Matrices only go back to the GPU when the grid changes, a static grid costs nothing per frame but the draw.
+  // Packets are executed in order, so the buffer keeps the last grid any packet uploaded
+  if (dirty_) {
+    void* instances = packet.AllocateUpload(*instance_buffer_, instance_count_ * sizeof(Instance));
+    BuildInstances(static_cast<Instance*>(instances));
+    dirty_ = false;
+  }
+
+  DrawPacket* draw = packet.AddDraw("instanced");
+  if (!draw) return;
+  draw->vao = vao_.get();
+  draw->ib = index_buffer_.get();
+  draw->textures[0] = texture_.get();
+  draw->instance_count = instance_count_;
+}
+
+void TestInstancing::OnImGuiRender() {
+  if (ImGui::SliderInt("instances", &instance_count_, 1, kMaxInstances)) {
+    dirty_ = true;
+  }
+  ImGui::Checkbox("animate", &animate_);
+  ImGui::Text("%d quads in 1 draw call", instance_count_);
+}
+}  // namespace test
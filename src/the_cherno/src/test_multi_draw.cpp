@@ -0,0 +1,105 @@
+#include "test_multi_draw.h"
+#include <cmath>
+#include "glm/gtc/matrix_transform.hpp"
+#include "gl_extensions.h"
+#include "imgui.h"
+#include "renderer.h"
+#include "shader_library.h"
+#include "vertex_buffer_layout.h"
+
+namespace test {
+struct FlatVertex {
+  glm::vec2 position;
+  glm::vec4 color;
+};
+
+static constexpr int kMaxSides = 16;
+
+TestMultiDraw::TestMultiDraw()
+    : proj_(glm::ortho(0.0f, 960.0f, 0.0f, 720.0f, -1.0f, 1.0f)),
+      draw_count_(kMeshCount),
+      multi_draw_(true),
+      last_calls_(0) {
+  VertexBufferLayout layout;
+  layout.Push<float>(2);
+  layout.Push<float>(4);
+  meshes_ = std::make_unique<MeshBuffer>(layout, kMeshCount * (kMaxSides + 1), kMeshCount * kMaxSides * 3);
+  commands_ = std::make_unique<DrawIndirectBuffer>(kMeshCount);
+  shared_vao_ = std::make_unique<VertexArray>();
+  shared_vao_->AddFormat(layout);
+
+  // Every mesh is a different fan-triangulated polygon, baked at its place in the scene
+  FlatVertex vertices[kMaxSides + 1];
+  unsigned int indices[kMaxSides * 3];
+  for (int i = 0; i < kMeshCount; i++) {
+    unsigned int seed = (i + 1) * 2654435761u;
+    int sides = 3 + seed % (kMaxSides - 2);
+    float radius = 4.0f + (seed >> 4) % 12;
+    glm::vec2 center((seed >> 8) % 960, (seed >> 18) % 720);
+    glm::vec4 color((seed >> 8 & 0xff) / 255.0f, (seed >> 16 & 0xff) / 255.0f, (seed >> 24 & 0xff) / 255.0f, 1.0f);
+
+    vertices[0] = {center, color};
+    for (int s = 0; s < sides; s++) {
+      float angle = 6.2831853f * s / sides;
+      vertices[s + 1] = {center + radius * glm::vec2(std::cos(angle), std::sin(angle)), color * 0.7f};
+      indices[s * 3 + 0] = 0;
+      indices[s * 3 + 1] = s + 1;
+      indices[s * 3 + 2] = (s + 1) % sides + 1;
+    }
+    ranges_.push_back(meshes_->Add(vertices, sides + 1, indices, sides * 3));
+
+    mesh_vertices_.push_back(std::make_unique<VertexBuffer>(vertices, (sides + 1) * sizeof(FlatVertex)));
+    shared_vao_->Bind();  // the index buffer binding is recorded in whichever vao is bound
+    mesh_indices_.push_back(std::make_unique<IndexBuffer>(indices, sides * 3));
+  }
+
+  ShaderLibrary::Get().Load("flat", "assets/shaders/flat.shader");
+}
+
+TestMultiDraw::~TestMultiDraw() {}
+
+void TestMultiDraw::OnUpdate(float deltaTime) {}
+
+void TestMultiDraw::OnRender() {
+  GLCall(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
+  GLCall(glClear(GL_COLOR_BUFFER_BIT));
+
+  Renderer renderer;
+  Shader& shader = ShaderLibrary::Get().Get("flat");
+
+  if (!camera_) {
+    camera_ = std::make_unique<UniformBuffer>(shader.GetUniformBlockLayout(kCameraBlockName), kCameraBlockBinding);
+  }
+  camera_->SetMat4f("u_view_proj", proj_);
+  camera_->Upload();
+  camera_->Bind();
+
+  GLCall(glDisable(GL_BLEND));
+  if (!multi_draw_) {
+    // Only the vertex buffer binding changes between meshes, the vao and its format stay put
+    for (int i = 0; i < draw_count_; i++) {
+      shared_vao_->SetVertexBuffer(0, *mesh_vertices_[i]);
+      renderer.Draw(*shared_vao_, *mesh_indices_[i], shader);
+    }
+    last_calls_ = draw_count_;
+    return;
+  }
+
+  commands_->Clear();
+  for (int i = 0; i < draw_count_; i++) {
+    commands_->Add(ranges_[i]);
+  }
+  last_calls_ = renderer.DrawIndirect(meshes_->GetVertexArray(), meshes_->GetIndexBuffer(), shader, *commands_);
+}
+
+void TestMultiDraw::OnImGuiRender() {
+  ImGui::SliderInt("meshes", &draw_count_, 0, kMeshCount);
+  ImGui::Checkbox("multi-draw", &multi_draw_);
+  const char* path = "glDrawElements per mesh, one shared vao";
+  if (multi_draw_) {
+    path = DrawIndirectBuffer::IsIndirectSupported() ? "glMultiDrawElementsIndirect" : "glMultiDrawElementsBaseVertex";
+  }
+  ImGui::Text("%d meshes in %u draw call(s) via %s", draw_count_, last_calls_, path);
+  ImGui::Text("Vertex attrib binding: %s", GLAD_GL_ARB_vertex_attrib_binding ? "native" : "emulated");
+}
+}  // namespace test
@@ -1,11 +1,20 @@
 #include "test_texture2d.h"
+#include "frame_packet.h"
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "imgui.h"
 #include "renderer.h"
+#include "shader_library.h"
+#include "texture_loader.h"
 #include "vertex_buffer_layout.h"
 
 namespace test {
+// One record per copy of the quad, read by instanced.shader at locations 2..6
+struct QuadInstance {
+  glm::mat4 model;
+  glm::vec4 color;
+};
+
 TestTexture2D::TestTexture2D()
     : proj_(glm::ortho(0.0f, 960.0f, 0.0f, 720.0f, -1.0f, 1.0f)),
       view_(glm::translate(glm::mat4(1.0f), glm::vec3(-100, 0, 0))),
@@ -31,53 +40,46 @@ TestTexture2D::TestTexture2D()
   layout.Push<float>(2);
   vao_->AddBuffer(*vertex_buffer_, layout);
 
+  instance_buffer_ = std::make_unique<VertexBuffer>(2 * sizeof(QuadInstance));
+  VertexBufferLayout instance_layout(1);
+  instance_layout.Push<glm::mat4>(1);
+  instance_layout.Push<float>(4);
+  vao_->AddBuffer(*instance_buffer_, instance_layout);
+
   index_buffer_ = std::make_unique<IndexBuffer>(indices, 6);
 
-  shader_ = std::make_unique<Shader>("assets/shaders/basic.shader");
-  shader_->Bind();
-  shader_->SetUniform4f("u_color", 0.2f, 0.3f, 0.8f, 1.0f);
-  shader_->SetUniform1i("u_texture", 0);
+  ShaderLibrary::Get().Load("instanced", "assets/shaders/instanced.shader", {},
+                            [](Shader& shader) { shader.SetUniform1i("u_texture", 0); });
 
-  texture_ = std::make_unique<Texture>("assets/textures/cat.jpg");
+  texture_ = TextureLoader::Get().Load("assets/textures/cat.jpg");
 }
 
 TestTexture2D::~TestTexture2D() {}
 
 void TestTexture2D::OnUpdate(float deltaTime) {}
 
-void TestTexture2D::OnRender() {
-  GLCall(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
-  GLCall(glClear(GL_COLOR_BUFFER_BIT));
-
-  Renderer renderer;
-
-  texture_->Bind();
-
-  {
-    glm::mat4 model = glm::translate(glm::mat4(1.0f), translation_a_);
-    glm::mat4 mvp = proj_ * view_ * model;
-
-    shader_->Bind();
-    shader_->SetUniformMat4f("u_mvp", mvp);
-
-    renderer.Draw(*vao_, *index_buffer_, *shader_);
-  }
-
-  {
-    glm::mat4 model = glm::translate(glm::mat4(1.0f), translation_b_);
-    glm::mat4 mvp = proj_ * view_ * model;
-
-    shader_->Bind();
-    shader_->SetUniformMat4f("u_mvp", mvp);
-
-    renderer.Draw(*vao_, *index_buffer_, *shader_);
-  }
+void TestTexture2D::OnExtract(FramePacket& packet) {
+  // View and projection go to the shared Camera block once per frame, only the model is per draw
+  packet.SetClearColor(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+  packet.SetViewProjection(proj_ * view_);
+
+  // Both copies go out as one instanced draw; their model matrices ride in the instance buffer
+  void* memory = packet.AllocateUpload(*instance_buffer_, 2 * sizeof(QuadInstance));
+  QuadInstance* instances = static_cast<QuadInstance*>(memory);
+  instances[0] = {glm::translate(glm::mat4(1.0f), translation_a_), glm::vec4(1.0f)};
+  instances[1] = {glm::translate(glm::mat4(1.0f), translation_b_), glm::vec4(1.0f)};
+
+  DrawPacket* draw = packet.AddDraw("instanced");
+  if (!draw) return;
+  draw->vao = vao_.get();
+  draw->ib = index_buffer_.get();
+  draw->textures[0] = texture_.get();
+  draw->blend = BlendMode::kAlpha;
+  draw->instance_count = 2;
 }
 
 void TestTexture2D::OnImGuiRender() {
   ImGui::SliderFloat3("translation_a_", &translation_a_.x, 0.0f, 960.0f);
   ImGui::SliderFloat3("translation_b_", &translation_b_.x, 0.0f, 960.0f);
-  ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate,
-              ImGui::GetIO().Framerate);
 }
 }  // namespace test
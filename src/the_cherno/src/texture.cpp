@@ -1,33 +1,225 @@
 #include "texture.h"
+#include <algorithm>
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
+#include "mapped_file.h"
+#include "mipmap.h"
 #include "stb_image.h"
 
-Texture::Texture(const std::string& path)
-    : renderer_id_(0), file_path_(path), local_buffer_(nullptr), width_(0), height_(0), bpp_(0) {
+Texture::Texture(const std::string& path, MipmapMode mipmaps)
+    : renderer_id_(0),
+      file_path_(path),
+      local_buffer_(nullptr),
+      width_(0),
+      height_(0),
+      bpp_(0),
+      levels_(0),
+      mipmaps_(mipmaps),
+      internal_format_(GL_RGBA8),
+      bindless_handle_(0) {
+  // Decoders and uploads read the mapped file directly, without a stdio copy in between
+  MappedFile file(path);
+  if (IsKtxPath(path)) {
+    CompressedImageView image;
+    if (file.IsOpen() && ParseKtx(file.GetData(), file.GetSize(), image)) {
+      UploadCompressed(image);
+    } else {
+      Upload(nullptr);
+    }
+    return;
+  }
+
   stbi_set_flip_vertically_on_load(1);
-  local_buffer_ = stbi_load(path.c_str(), &width_, &height_, &bpp_, 4);
+  if (file.IsOpen()) {
+    local_buffer_ = stbi_load_from_memory(file.GetData(), file.GetSize(), &width_, &height_, &bpp_, 4);
+  }
+
+  Upload(local_buffer_);
+
+  if (local_buffer_) {
+    stbi_image_free(local_buffer_);
+  }
+}
+
+Texture::Texture(int width, int height, const unsigned char* data, MipmapMode mipmaps)
+    : renderer_id_(0),
+      local_buffer_(nullptr),
+      width_(width),
+      height_(height),
+      bpp_(4),
+      levels_(0),
+      mipmaps_(mipmaps),
+      internal_format_(GL_RGBA8),
+      bindless_handle_(0) {
+  Upload(data);
+}
+
+Texture::Texture(const CompressedImage& image)
+    : renderer_id_(0),
+      local_buffer_(nullptr),
+      width_(0),
+      height_(0),
+      bpp_(0),
+      levels_(0),
+      mipmaps_(MipmapMode::kNone),
+      internal_format_(GL_RGBA8),
+      bindless_handle_(0) {
+  UploadCompressed(image.GetView());
+}
 
-  GLCall(glGenTextures(1, &renderer_id_));
-  GLCall(glBindTexture(GL_TEXTURE_2D, renderer_id_));
+Texture::~Texture() {
+  ReleaseBindlessHandle();
+  GLCall(glDeleteTextures(1, &renderer_id_));
+  GLStateCache::Get().OnDeleteTexture(renderer_id_);
+}
+
+void Texture::Bind(unsigned int slot) const { GLStateCache::Get().BindTexture(GL_TEXTURE_2D, slot, renderer_id_); }
+
+void Texture::Unbind(unsigned int slot) { GLStateCache::Get().BindTexture(GL_TEXTURE_2D, slot, 0); }
+
+// glTex* calls act on the active unit, which Bind leaves alone when the texture is already bound to the slot
+void Texture::BindForEdit() const {
+  Bind(0);
+  GLStateCache::Get().ActiveTexture(0);
+}
+
+void Texture::Upload(const unsigned char* data) {
+  // Immutable storage can't be 0x0, so an image that failed to load becomes a 1x1 magenta texture
+  const unsigned char magenta[] = {0xff, 0x00, 0xff, 0xff};
+  if (!data) {
+    width_ = height_ = 1;
+    data = magenta;
+  }
+
+  SetData(width_, height_, data);
+  if (mipmaps_ == MipmapMode::kCpu) {
+    std::vector<MipLevel> chain = GenerateMipChain(data, width_, height_);
+    for (size_t i = 0; i < chain.size(); i++) {
+      SetLevelData(i + 1, chain[i].pixels.data());
+    }
+  }
+  Unbind();
+}
+
+void Texture::UploadCompressed(const CompressedImageView& image) {
+  if (!IsFormatSupported(image.format)) {
+    std::cout << "Warning: " << GetBlockFormatName(image.format) << " textures aren't supported here" << std::endl;
+    Upload(nullptr);
+    return;
+  }
+  SetCompressedData(image);
+  Unbind();
+}
 
-  GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+void Texture::Allocate(int width, int height) {
+  width_ = width;
+  height_ = height;
+  bpp_ = 4;
+  AllocateStorage(GL_RGBA8, mipmaps_ == MipmapMode::kNone ? 1 : GetMipLevelCount(width_, height_));
+}
+
+void Texture::AllocateCompressed(BlockFormat format, int width, int height, int levels) {
+  width_ = width;
+  height_ = height;
+  bpp_ = 0;
+  AllocateStorage(GetGLInternalFormat(format), levels);
+}
+
+void Texture::AllocateStorage(unsigned int internal_format, int levels) {
+  internal_format_ = internal_format;
+  levels_ = levels;
+
+  // Immutable storage fixes the size for the texture's lifetime, so a new size needs a new object
+  // A texture with a bindless handle is frozen as well
+  bool recreate = GLAD_GL_ARB_texture_storage || bindless_handle_ != 0;
+  ReleaseBindlessHandle();
+  if (renderer_id_ && recreate) {
+    GLCall(glDeleteTextures(1, &renderer_id_));
+    GLStateCache::Get().OnDeleteTexture(renderer_id_);
+    renderer_id_ = 0;
+  }
+  if (!renderer_id_) GLCall(glGenTextures(1, &renderer_id_));
+  BindForEdit();
+
+  GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels_ > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
   GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
   GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
   GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
 
-  GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width_, height_, 0, GL_RGBA, GL_UNSIGNED_BYTE,
-                      local_buffer_));
-  GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+  if (GLAD_GL_ARB_texture_storage) {
+    GLCall(glTexStorage2D(GL_TEXTURE_2D, levels_, internal_format_, width_, height_));
+  } else {
+    // Mutable fallback: levels are defined as they are uploaded, MAX_LEVEL keeps the texture complete
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels_ - 1));
+  }
+}
 
-  if (local_buffer_) {
-    stbi_image_free(local_buffer_);
+void Texture::SetLevelData(int level, const void* data) {
+  int width = std::max(1, width_ >> level);
+  int height = std::max(1, height_ >> level);
+  BindForEdit();
+  if (GLAD_GL_ARB_texture_storage) {
+    GLCall(glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data));
+  } else {
+    GLCall(glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data));
   }
 }
 
-Texture::~Texture() { GLCall(glDeleteTextures(1, &renderer_id_)); }
+void Texture::GenerateMipmaps() {
+  if (levels_ <= 1 || IsCompressed()) return;
+  BindForEdit();
+  GLCall(glGenerateMipmap(GL_TEXTURE_2D));
+}
 
-void Texture::Bind(unsigned int slot) const {
-  GLCall(glActiveTexture(GL_TEXTURE0 + slot));
-  GLCall(glBindTexture(GL_TEXTURE_2D, renderer_id_));
+void Texture::SetData(int width, int height, const void* data) {
+  Allocate(width, height);
+  SetLevelData(0, data);
+  if (mipmaps_ == MipmapMode::kGenerate) GenerateMipmaps();
 }
 
-void Texture::Unbind() { GLCall(glBindTexture(GL_TEXTURE_2D, 0)); }
+void Texture::SetCompressedLevelData(int level, const void* data, size_t size) {
+  int width = std::max(1, width_ >> level);
+  int height = std::max(1, height_ >> level);
+  BindForEdit();
+  if (GLAD_GL_ARB_texture_storage) {
+    GLCall(glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, internal_format_, size, data));
+  } else {
+    GLCall(glCompressedTexImage2D(GL_TEXTURE_2D, level, internal_format_, width, height, 0, size, data));
+  }
+}
+
+void Texture::SetCompressedData(const CompressedImageView& image) {
+  AllocateCompressed(image.format, image.width, image.height, image.levels.size());
+  for (size_t i = 0; i < image.levels.size(); i++) {
+    SetCompressedLevelData(i, image.levels[i].data, image.levels[i].size);
+  }
+}
+
+uint64_t Texture::GetBindlessHandle() const {
+  if (!bindless_handle_ && GLAD_GL_ARB_bindless_texture) {
+    GLCall(bindless_handle_ = glGetTextureHandleARB(renderer_id_));
+    GLCall(glMakeTextureHandleResidentARB(bindless_handle_));
+  }
+  return bindless_handle_;
+}
+
+void Texture::ReleaseBindlessHandle() {
+  if (!bindless_handle_) return;
+  GLCall(glMakeTextureHandleNonResidentARB(bindless_handle_));
+  bindless_handle_ = 0;
+}
+
+bool Texture::IsFormatSupported(BlockFormat format) {
+  switch (format) {
+    case BlockFormat::kBC1:
+    case BlockFormat::kBC3:
+      return GLAD_GL_EXT_texture_compression_s3tc;
+    case BlockFormat::kBC7:
+      return GLAD_GL_ARB_texture_compression_bptc;
+    case BlockFormat::kETC2_RGB:
+    case BlockFormat::kETC2_RGBA:
+      return GLAD_GL_ARB_ES3_compatibility;
+  }
+  return false;
+}
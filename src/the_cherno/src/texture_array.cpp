@@ -0,0 +1,83 @@
+#include "texture_array.h"
+#include <algorithm>
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
+#include "mapped_file.h"
+#include "mipmap.h"
+#include "stb_image.h"
+
+TextureArray::TextureArray(int width, int height, unsigned int layers, MipmapMode mipmaps)
+    : renderer_id_(0),
+      width_(width),
+      height_(height),
+      layers_(layers),
+      levels_(mipmaps == MipmapMode::kNone ? 1 : GetMipLevelCount(width, height)),
+      mipmaps_(mipmaps) {
+  GLCall(glGenTextures(1, &renderer_id_));
+  BindForEdit();
+
+  GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+                         levels_ > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
+  GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+  GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+  GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+
+  if (GLAD_GL_ARB_texture_storage) {
+    GLCall(glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels_, GL_RGBA8, width_, height_, layers_));
+  } else {
+    GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels_ - 1));
+    for (int level = 0; level < levels_; level++) {
+      GLCall(glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, std::max(1, width_ >> level),
+                          std::max(1, height_ >> level), layers_, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+    }
+  }
+}
+
+TextureArray::~TextureArray() {
+  GLCall(glDeleteTextures(1, &renderer_id_));
+  GLStateCache::Get().OnDeleteTexture(renderer_id_);
+}
+
+void TextureArray::SetLayer(unsigned int layer, const unsigned char* data) {
+  ASSERT(layer < layers_);
+  BindForEdit();
+  GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width_, height_, 1, GL_RGBA, GL_UNSIGNED_BYTE, data));
+  if (mipmaps_ != MipmapMode::kCpu) return;
+
+  std::vector<MipLevel> chain = GenerateMipChain(data, width_, height_);
+  for (size_t i = 0; i < chain.size(); i++) {
+    GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, i + 1, 0, 0, layer, chain[i].width, chain[i].height, 1, GL_RGBA,
+                           GL_UNSIGNED_BYTE, chain[i].pixels.data()));
+  }
+}
+
+bool TextureArray::SetLayer(unsigned int layer, const std::string& path) {
+  stbi_set_flip_vertically_on_load(1);
+  int width, height, channels;
+  MappedFile file(path);
+  unsigned char* pixels =
+      file.IsOpen() ? stbi_load_from_memory(file.GetData(), file.GetSize(), &width, &height, &channels, 4) : nullptr;
+  if (!pixels || width != width_ || height != height_) {
+    std::cout << "Warning: " << path << " can't be a " << width_ << "x" << height_ << " array layer" << std::endl;
+    if (pixels) stbi_image_free(pixels);
+    return false;
+  }
+  SetLayer(layer, pixels);
+  stbi_image_free(pixels);
+  return true;
+}
+
+void TextureArray::GenerateMipmaps() {
+  if (levels_ <= 1) return;
+  BindForEdit();
+  GLCall(glGenerateMipmap(GL_TEXTURE_2D_ARRAY));
+}
+
+void TextureArray::Bind(unsigned int slot) const {
+  GLStateCache::Get().BindTexture(GL_TEXTURE_2D_ARRAY, slot, renderer_id_);
+}
+
+void TextureArray::BindForEdit() const {
+  Bind(0);
+  GLStateCache::Get().ActiveTexture(0);
+}
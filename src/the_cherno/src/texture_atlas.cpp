@@ -0,0 +1,232 @@
+#include "texture_atlas.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
+#include "mapped_file.h"
+#include "renderer.h"
+#include "stb_image.h"
+
+// imgui compiles its own static copy; this one is private to the atlas, and doesn't use all of it
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#endif
+#include "imstb_rectpack.h"
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+struct TextureAtlas::Layer {
+  stbrp_context packer;
+  std::vector<stbrp_node> nodes;
+  std::vector<Rect> free_rects;  // space freed by Remove, reused before the skyline
+  unsigned int image_count = 0;
+};
+
+TextureAtlas::TextureAtlas(int width, int height, unsigned int max_layers, int padding)
+    : renderer_id_(0),
+      width_(width),
+      height_(height),
+      max_layers_(std::max(max_layers, 1u)),
+      layer_count_(0),
+      padding_(padding),
+      next_handle_(kInvalidHandle + 1) {}
+
+TextureAtlas::~TextureAtlas() {
+  if (!renderer_id_) return;
+  GLCall(glDeleteTextures(1, &renderer_id_));
+  GLStateCache::Get().OnDeleteTexture(renderer_id_);
+}
+
+TextureAtlas::Handle TextureAtlas::Insert(int width, int height, const unsigned char* data) {
+  int padded_width = width + 2 * padding_;
+  int padded_height = height + 2 * padding_;
+  unsigned int layer;
+  Rect rect;
+  if (width <= 0 || height <= 0 || !Allocate(padded_width, padded_height, layer, rect)) {
+    std::cout << "Warning: no room for a " << width << "x" << height << " image in the atlas" << std::endl;
+    return kInvalidHandle;
+  }
+
+  // Repeat the edge texels into the padding
+  std::vector<unsigned char> padded((size_t)padded_width * padded_height * 4);
+  for (int y = 0; y < padded_height; y++) {
+    int src_y = std::clamp(y - padding_, 0, height - 1);
+    for (int x = 0; x < padded_width; x++) {
+      int src_x = std::clamp(x - padding_, 0, width - 1);
+      memcpy(&padded[((size_t)y * padded_width + x) * 4], &data[((size_t)src_y * width + src_x) * 4], 4);
+    }
+  }
+  GLStateCache::Get().BindTexture(GL_TEXTURE_2D_ARRAY, 0, renderer_id_);
+  GLStateCache::Get().ActiveTexture(0);
+  GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, rect.x, rect.y, layer, padded_width, padded_height, 1, GL_RGBA,
+                         GL_UNSIGNED_BYTE, padded.data()));
+
+  Region region;
+  region.layer = layer;
+  region.x = rect.x + padding_;
+  region.y = rect.y + padding_;
+  region.width = width;
+  region.height = height;
+  region.uv_min = glm::vec2((float)region.x / width_, (float)region.y / height_);
+  region.uv_max = glm::vec2((float)(region.x + width) / width_, (float)(region.y + height) / height_);
+
+  Handle handle = next_handle_++;
+  regions_[handle] = region;
+  layers_[layer]->image_count++;
+  return handle;
+}
+
+TextureAtlas::Handle TextureAtlas::Insert(const std::string& path) {
+  stbi_set_flip_vertically_on_load(1);
+  int width, height, channels;
+  MappedFile file(path);
+  unsigned char* pixels =
+      file.IsOpen() ? stbi_load_from_memory(file.GetData(), file.GetSize(), &width, &height, &channels, 4) : nullptr;
+  if (!pixels) {
+    std::cout << "Warning: failed to load texture " << path << std::endl;
+    return kInvalidHandle;
+  }
+  Handle handle = Insert(width, height, pixels);
+  stbi_image_free(pixels);
+  return handle;
+}
+
+void TextureAtlas::Remove(Handle handle) {
+  auto it = regions_.find(handle);
+  if (it == regions_.end()) return;
+
+  const Region& region = it->second;
+  Layer& layer = *layers_[region.layer];
+  layer.free_rects.push_back({region.x - padding_, region.y - padding_, region.width + 2 * padding_,
+                              region.height + 2 * padding_});
+  if (--layer.image_count == 0) ResetLayer(layer);
+  regions_.erase(it);
+}
+
+void TextureAtlas::Clear() {
+  regions_.clear();
+  for (auto& layer : layers_) {
+    layer->image_count = 0;
+    ResetLayer(*layer);
+  }
+}
+
+const TextureAtlas::Region* TextureAtlas::GetRegion(Handle handle) const {
+  auto it = regions_.find(handle);
+  return it != regions_.end() ? &it->second : nullptr;
+}
+
+void TextureAtlas::Bind(unsigned int slot) const {
+  GLStateCache::Get().BindTexture(GL_TEXTURE_2D_ARRAY, slot, renderer_id_);
+}
+
+bool TextureAtlas::Allocate(int width, int height, unsigned int& layer, Rect& rect) {
+  if (width > width_ || height > height_) return false;
+
+  for (layer = 0; layer < layer_count_; layer++) {
+    if (AllocateFromFreeList(*layers_[layer], width, height, rect)) return true;
+  }
+
+  while (true) {
+    for (layer = 0; layer < layer_count_; layer++) {
+      stbrp_rect packed = {};
+      packed.w = width;
+      packed.h = height;
+      if (stbrp_pack_rects(&layers_[layer]->packer, &packed, 1) && packed.was_packed) {
+        rect = {packed.x, packed.y, width, height};
+        return true;
+      }
+    }
+    if (!Grow()) return false;
+  }
+}
+
+// Best area fit, then a guillotine split of what is left along the shorter leftover side
+bool TextureAtlas::AllocateFromFreeList(Layer& layer, int width, int height, Rect& rect) {
+  int best = -1;
+  long best_area = std::numeric_limits<long>::max();
+  for (int i = 0; i < (int)layer.free_rects.size(); i++) {
+    const Rect& free = layer.free_rects[i];
+    long area = (long)free.width * free.height;
+    if (free.width >= width && free.height >= height && area < best_area) {
+      best = i;
+      best_area = area;
+    }
+  }
+  if (best < 0) return false;
+
+  Rect free = layer.free_rects[best];
+  layer.free_rects.erase(layer.free_rects.begin() + best);
+  rect = {free.x, free.y, width, height};
+
+  int leftover_width = free.width - width;
+  int leftover_height = free.height - height;
+  Rect right, bottom;
+  if (leftover_width < leftover_height) {
+    right = {free.x + width, free.y, leftover_width, height};
+    bottom = {free.x, free.y + height, free.width, leftover_height};
+  } else {
+    right = {free.x + width, free.y, leftover_width, free.height};
+    bottom = {free.x, free.y + height, width, leftover_height};
+  }
+  if (right.width > 0 && right.height > 0) layer.free_rects.push_back(right);
+  if (bottom.width > 0 && bottom.height > 0) layer.free_rects.push_back(bottom);
+  return true;
+}
+
+// Reallocates the array with twice the layers and copies the old layers over through a read framebuffer;
+// glCopyImageSubData would do it in one call but needs GL 4.3
+bool TextureAtlas::Grow() {
+  if (layer_count_ >= max_layers_) return false;
+  unsigned int layer_count = std::min(std::max(layer_count_ * 2, 1u), max_layers_);
+
+  unsigned int texture;
+  GLCall(glGenTextures(1, &texture));
+  GLStateCache::Get().BindTexture(GL_TEXTURE_2D_ARRAY, 0, texture);
+  GLStateCache::Get().ActiveTexture(0);
+  GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+  GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+  GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+  GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+  if (GLAD_GL_ARB_texture_storage) {
+    GLCall(glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8, width_, height_, layer_count));
+  } else {
+    GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0));
+    GLCall(glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width_, height_, layer_count, 0, GL_RGBA,
+                        GL_UNSIGNED_BYTE, nullptr));
+  }
+
+  if (renderer_id_) {
+    unsigned int framebuffer;
+    GLCall(glGenFramebuffers(1, &framebuffer));
+    GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer));
+    for (unsigned int layer = 0; layer < layer_count_; layer++) {
+      GLCall(glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, renderer_id_, 0, layer));
+      GLCall(glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, 0, 0, width_, height_));
+    }
+    GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, 0));
+    GLCall(glDeleteFramebuffers(1, &framebuffer));
+
+    GLCall(glDeleteTextures(1, &renderer_id_));
+    GLStateCache::Get().OnDeleteTexture(renderer_id_);
+  }
+  renderer_id_ = texture;
+
+  for (unsigned int i = layer_count_; i < layer_count; i++) {
+    layers_.push_back(std::make_unique<Layer>());
+    layers_.back()->nodes.resize(width_);
+    ResetLayer(*layers_.back());
+  }
+  layer_count_ = layer_count;
+  return true;
+}
+
+void TextureAtlas::ResetLayer(Layer& layer) {
+  stbrp_init_target(&layer.packer, width_, height_, layer.nodes.data(), layer.nodes.size());
+  layer.free_rects.clear();
+}
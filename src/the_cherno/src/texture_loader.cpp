@@ -0,0 +1,212 @@
+#include "texture_loader.h"
+#include <algorithm>
+#include <cstring>
+#include "profiler.h"
+#include "renderer.h"
+#include "stb_image.h"
+#include "trace_recorder.h"
+
+TextureLoader& TextureLoader::Get() {
+  static TextureLoader loader;
+  return loader;
+}
+
+TextureLoader::TextureLoader() : stopping_(false), next_id_(0), pbo_(0), pbo_size_(0), upload_budget_(8 << 20) {}
+
+TextureLoader::~TextureLoader() {
+  // GL objects are gone with the context by now; only make sure the threads are joined
+  std::unique_lock<std::mutex> lock(mutex_);
+  stopping_ = true;
+  lock.unlock();
+  cv_.notify_all();
+  for (std::thread& worker : workers_) worker.join();
+}
+
+std::shared_ptr<Texture> TextureLoader::Load(const std::string& path, MipmapMode mipmaps) {
+  auto it = textures_.find(path);
+  if (it != textures_.end()) {
+    if (std::shared_ptr<Texture> texture = it->second.lock()) return texture;
+  }
+
+  const unsigned char grey[] = {0x80, 0x80, 0x80, 0xff};
+  auto texture = std::make_shared<Texture>(1, 1, grey, mipmaps);
+  textures_[path] = texture;
+
+  unsigned int id = next_id_++;
+  pending_[id] = texture;
+  if (workers_.empty()) StartWorkers();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back({id, path, mipmaps});
+  }
+  cv_.notify_one();
+  return texture;
+}
+
+void TextureLoader::Update() {
+  PROFILE_SCOPE("Texture uploads");
+  size_t uploaded = 0;
+  while (true) {
+    Result result;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (results_.empty()) break;
+      // Always upload at least one image per frame so an image larger than the budget still arrives
+      size_t size = results_.front().GetSize();
+      if (uploaded > 0 && uploaded + size > upload_budget_) break;
+      result = std::move(results_.front());
+      results_.pop_front();
+    }
+
+    auto it = pending_.find(result.id);
+    std::shared_ptr<Texture> texture = it != pending_.end() ? it->second.lock() : nullptr;
+    if (it != pending_.end()) pending_.erase(it);
+
+    if (!result.IsValid()) continue;
+    if (texture) {
+      Upload(*texture, result);
+      uploaded += result.GetSize();
+    }
+    if (result.pixels) stbi_image_free(result.pixels);
+  }
+
+  if (uploaded > 0) GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+}
+
+void TextureLoader::Upload(Texture& texture, const Result& result) {
+  size_t size = result.GetSize();
+  // Allocate before the unpack buffer is bound, so the mutable fallback doesn't read from it
+  if (result.compressed) {
+    texture.AllocateCompressed(result.image.format, result.width, result.height, result.image.levels.size());
+  } else {
+    texture.Allocate(result.width, result.height);
+  }
+
+  if (!pbo_) GLCall(glGenBuffers(1, &pbo_));
+  GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_));
+
+  // Orphan, so the previous upload can still be in flight while this one is written
+  pbo_size_ = std::max(pbo_size_, size);
+  GLCall(glBufferData(GL_PIXEL_UNPACK_BUFFER, pbo_size_, nullptr, GL_STREAM_DRAW));
+  unsigned char* dst;
+  GLCall(dst = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+
+  // Levels are laid out back to back and uploaded from their offsets
+  size_t offset = 0;
+  if (result.compressed) {
+    for (const CompressedImageView::Level& level : result.image.levels) {
+      memcpy(dst + offset, level.data, level.size);
+      offset += level.size;
+    }
+  } else {
+    offset = (size_t)result.width * result.height * 4;
+    memcpy(dst, result.pixels, offset);
+    for (const MipLevel& mip : result.mips) {
+      memcpy(dst + offset, mip.pixels.data(), mip.pixels.size());
+      offset += mip.pixels.size();
+    }
+  }
+  GLCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+
+  if (result.compressed) {
+    offset = 0;
+    for (size_t i = 0; i < result.image.levels.size(); i++) {
+      size_t level_size = result.image.levels[i].size;
+      texture.SetCompressedLevelData(i, (const void*)offset, level_size);
+      offset += level_size;
+    }
+    return;
+  }
+
+  texture.SetLevelData(0, nullptr);
+  offset = (size_t)result.width * result.height * 4;
+  for (size_t i = 0; i < result.mips.size() && (int)i + 1 < texture.GetLevelCount(); i++) {
+    texture.SetLevelData(i + 1, (const void*)offset);
+    offset += result.mips[i].pixels.size();
+  }
+  if (texture.GetMipmapMode() == MipmapMode::kGenerate) texture.GenerateMipmaps();
+}
+
+void TextureLoader::Shutdown() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  for (std::thread& worker : workers_) worker.join();
+  workers_.clear();
+
+  for (Result& result : results_) {
+    if (result.pixels) stbi_image_free(result.pixels);
+  }
+  results_.clear();
+  jobs_.clear();
+  pending_.clear();
+  textures_.clear();
+
+  if (pbo_) GLCall(glDeleteBuffers(1, &pbo_));
+  pbo_ = 0;
+  pbo_size_ = 0;
+  stopping_ = false;
+}
+
+void TextureLoader::StartWorkers() {
+  unsigned int count = std::clamp(std::thread::hardware_concurrency(), 2u, 5u) - 1;
+  for (unsigned int i = 0; i < count; i++) {
+    workers_.emplace_back(&TextureLoader::WorkerLoop, this);
+  }
+}
+
+void TextureLoader::WorkerLoop() {
+  stbi_set_flip_vertically_on_load_thread(1);
+  TraceRecorder::Get().SetThreadName("Texture worker");
+
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return stopping_ || !jobs_.empty(); });
+      if (stopping_) return;
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+    }
+
+    TRACE_SCOPE("Decode texture");
+    Result result;
+    result.id = job.id;
+    MappedFile file(job.path);
+    if (IsKtxPath(job.path)) {
+      // Blocks stay in the mapping until Upload copies them into the unpack buffer
+      result.compressed = file.IsOpen() && ParseKtx(file.GetData(), file.GetSize(), result.image);
+      if (result.compressed && !Texture::IsFormatSupported(result.image.format)) {
+        std::cout << "Warning: " << GetBlockFormatName(result.image.format) << " isn't supported, skipping "
+                  << job.path << std::endl;
+        result.compressed = false;
+      } else if (result.compressed) {
+        result.width = result.image.width;
+        result.height = result.image.height;
+        result.file = std::move(file);
+      }
+    } else if (file.IsOpen()) {
+      int channels;
+      result.pixels =
+          stbi_load_from_memory(file.GetData(), file.GetSize(), &result.width, &result.height, &channels, 4);
+    }
+    if (!result.IsValid()) {
+      std::cout << "Warning: failed to load texture " << job.path << std::endl;
+    } else if (result.pixels && job.mipmaps == MipmapMode::kCpu) {
+      result.mips = GenerateMipChain(result.pixels, result.width, result.height);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    results_.push_back(std::move(result));
+  }
+}
+
+size_t TextureLoader::Result::GetSize() const {
+  if (compressed) return image.GetSize();
+  size_t size = (size_t)width * height * 4;
+  for (const MipLevel& mip : mips) size += mip.pixels.size();
+  return size;
+}
@@ -0,0 +1,162 @@
+#include "trace_recorder.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include "imgui.h"
+
+static const char* const kDefaultTracePath = "trace.json";
+
+TraceRecorder& TraceRecorder::Get() {
+  static TraceRecorder recorder;
+  return recorder;
+}
+
+// Buffers start at generation 0, so the first capture (generation 1) resets them before use
+TraceRecorder::TraceRecorder()
+    : recording_(false), generation_(0), epoch_(std::chrono::steady_clock::now()), frames_left_(0),
+      window_frames_(120) {}
+
+void TraceRecorder::Start() {
+  if (IsRecording()) return;
+  generation_.fetch_add(1, std::memory_order_release);
+  recording_.store(true, std::memory_order_release);
+  status_.clear();
+}
+
+void TraceRecorder::Stop() { recording_.store(false, std::memory_order_release); }
+
+void TraceRecorder::CaptureFrames(unsigned int frames, const std::string& path) {
+  Stop();
+  Start();
+  frames_left_ = frames;
+  capture_path_ = path;
+}
+
+void TraceRecorder::EndFrame() {
+  if (frames_left_ == 0 || --frames_left_ != 0) return;
+  Stop();
+  status_ = Dump(capture_path_) ? "Wrote " + capture_path_ : "Failed to write " + capture_path_;
+}
+
+uint64_t TraceRecorder::Now() const {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch_).count();
+}
+
+thread_local TraceRecorder::ThreadBuffer* TraceRecorder::t_buffer_ = nullptr;
+
+TraceRecorder::ThreadBuffer& TraceRecorder::GetThreadBuffer() {
+  if (!t_buffer_) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!free_buffers_.empty()) {
+      t_buffer_ = free_buffers_.back();
+      free_buffers_.pop_back();
+    } else {
+      buffers_.push_back(std::make_unique<ThreadBuffer>());
+      t_buffer_ = buffers_.back().get();
+      t_buffer_->tid = (unsigned int)buffers_.size();
+    }
+  }
+  return *t_buffer_;
+}
+
+void TraceRecorder::ReleaseThreadBuffer() {
+  if (!t_buffer_) return;
+  // The lock orders this thread's last writes before the next owner's first
+  std::lock_guard<std::mutex> lock(mutex_);
+  free_buffers_.push_back(t_buffer_);
+  t_buffer_ = nullptr;
+}
+
+void TraceRecorder::Record(const char* name, uint64_t begin_ns, uint64_t end_ns) {
+  ThreadBuffer& buffer = GetThreadBuffer();
+  uint32_t generation = generation_.load(std::memory_order_acquire);
+  if (buffer.generation.load(std::memory_order_relaxed) != generation) {
+    // First event of a new capture on this thread; the release below makes the reset visible before
+    // Dump can accept the buffer as part of the capture
+    if (!buffer.events) buffer.events = std::make_unique<Event[]>(kEventsPerThread);
+    buffer.count.store(0, std::memory_order_relaxed);
+    buffer.dropped.store(0, std::memory_order_relaxed);
+    buffer.generation.store(generation, std::memory_order_release);
+  }
+
+  uint32_t count = buffer.count.load(std::memory_order_relaxed);
+  if (count == kEventsPerThread) {
+    buffer.dropped.store(buffer.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return;
+  }
+  buffer.events[count] = {name, begin_ns, end_ns};
+  buffer.count.store(count + 1, std::memory_order_release);
+}
+
+void TraceRecorder::SetThreadName(const char* name) {
+  GetThreadBuffer().name.store(name, std::memory_order_relaxed);
+}
+
+static void WriteJsonString(std::ofstream& out, const char* value) {
+  out << '"';
+  for (const char* c = value; *c; c++) {
+    if (*c == '"' || *c == '\\') out << '\\';
+    out << *c;
+  }
+  out << '"';
+}
+
+bool TraceRecorder::Dump(const std::string& path) const {
+  std::ofstream out(path, std::ios::trunc);
+  if (!out) return false;
+
+  // Timestamps are microseconds; three decimals keep the nanoseconds
+  out << std::fixed << std::setprecision(3);
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  bool first = true;
+  uint32_t generation = generation_.load(std::memory_order_acquire);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const std::unique_ptr<ThreadBuffer>& buffer : buffers_) {
+    if (const char* name = buffer->name.load(std::memory_order_relaxed)) {
+      out << (first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->tid
+          << ",\"args\":{\"name\":";
+      WriteJsonString(out, name);
+      out << "}}";
+      first = false;
+    }
+    if (buffer->generation.load(std::memory_order_acquire) != generation) continue;
+
+    // Events past count may still be being written by a thread that saw the capture running
+    uint32_t count = buffer->count.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < count; i++) {
+      const Event& event = buffer->events[i];
+      out << (first ? "" : ",\n") << "{\"ph\":\"X\",\"name\":";
+      WriteJsonString(out, event.name);
+      out << ",\"pid\":1,\"tid\":" << buffer->tid << ",\"ts\":" << event.begin_ns / 1000.0
+          << ",\"dur\":" << (event.end_ns - event.begin_ns) / 1000.0 << "}";
+      first = false;
+    }
+    if (uint32_t dropped = buffer->dropped.load(std::memory_order_relaxed)) {
+      std::cout << "Warning: trace buffer of thread " << buffer->tid << " was full, " << dropped
+                << " events dropped" << std::endl;
+    }
+  }
+  out << "\n]}\n";
+  return (bool)out;
+}
+
+void TraceRecorder::OnImGuiRender() {
+  if (!ImGui::CollapsingHeader("Trace")) return;
+
+  if (frames_left_ != 0) {
+    ImGui::Text("Capturing, %u frames left", frames_left_);
+  } else if (IsRecording()) {
+    if (ImGui::Button("Stop and write")) {
+      Stop();
+      status_ = Dump(kDefaultTracePath) ? std::string("Wrote ") + kDefaultTracePath
+                                        : std::string("Failed to write ") + kDefaultTracePath;
+    }
+  } else {
+    ImGui::SliderInt("frames", &window_frames_, 1, 1000);
+    if (ImGui::Button("Capture")) CaptureFrames(window_frames_, kDefaultTracePath);
+    ImGui::SameLine();
+    if (ImGui::Button("Start")) Start();
+  }
+  if (!status_.empty()) ImGui::TextUnformatted(status_.c_str());
+}
@@ -0,0 +1,58 @@
+#include "uniform_buffer.h"
+#include <algorithm>
+#include <cstring>
+#include "gl_state_cache.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/type_ptr.hpp"
+#include "renderer.h"
+
+UniformBuffer::UniformBuffer(const UniformBlockLayout& layout, unsigned int binding)
+    : binding_(binding), layout_(layout), data_(layout.size), dirty_begin_(layout.size), dirty_end_(0) {
+  GLCall(glGenBuffers(1, &renderer_id_));
+  GLCall(glBindBuffer(GL_UNIFORM_BUFFER, renderer_id_));
+  GLCall(glBufferData(GL_UNIFORM_BUFFER, layout_.size, nullptr, GL_DYNAMIC_DRAW));
+  Bind();
+}
+
+UniformBuffer::~UniformBuffer() {
+  GLCall(glDeleteBuffers(1, &renderer_id_));
+  GLStateCache::Get().OnDeleteBuffer(renderer_id_);
+}
+
+void UniformBuffer::Bind() const { GLCall(glBindBufferBase(GL_UNIFORM_BUFFER, binding_, renderer_id_)); }
+
+void UniformBuffer::SetInt(const std::string& member, int value) { Write(member, &value, sizeof(value)); }
+
+void UniformBuffer::SetFloat(const std::string& member, float value) { Write(member, &value, sizeof(value)); }
+
+void UniformBuffer::SetVec4f(const std::string& member, const glm::vec4& value) {
+  Write(member, glm::value_ptr(value), sizeof(value));
+}
+
+// std140 stores a column-major mat4 as four vec4 columns, which is exactly glm's layout
+void UniformBuffer::SetMat4f(const std::string& member, const glm::mat4& value) {
+  Write(member, glm::value_ptr(value), sizeof(value));
+}
+
+void UniformBuffer::Upload() {
+  if (dirty_begin_ >= dirty_end_) return;
+
+  GLCall(glBindBuffer(GL_UNIFORM_BUFFER, renderer_id_));
+  GLCall(glBufferSubData(GL_UNIFORM_BUFFER, dirty_begin_, dirty_end_ - dirty_begin_, data_.data() + dirty_begin_));
+  dirty_begin_ = layout_.size;
+  dirty_end_ = 0;
+}
+
+void UniformBuffer::Write(const std::string& member, const void* data, unsigned int size) {
+  auto it = layout_.offsets.find(member);
+  if (it == layout_.offsets.end()) {
+    std::cout << "Warning: uniform block '" << layout_.name << "' has no member '" << member << "'" << std::endl;
+    return;
+  }
+
+  unsigned int offset = it->second;
+  ASSERT(offset + size <= layout_.size);
+  memcpy(data_.data() + offset, data, size);
+  dirty_begin_ = std::min(dirty_begin_, offset);
+  dirty_end_ = std::max(dirty_end_, offset + size);
+}
@@ -1,28 +1,78 @@
 #include "vertex_array.h"
 #include <cstdint>
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
 #include "renderer.h"
 #include "vertex_buffer_layout.h"
 
-VertexArray::VertexArray() { GLCall(glGenVertexArrays(1, &renderer_id_)); }
+static constexpr unsigned int kNoBuffer = 0xffffffffu;
 
-VertexArray::~VertexArray() { GLCall(glDeleteVertexArrays(1, &renderer_id_)); }
+VertexArray::VertexArray() : next_attribute_(0) { GLCall(glGenVertexArrays(1, &renderer_id_)); }
 
-void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout) {
+VertexArray::~VertexArray() {
+  GLCall(glDeleteVertexArrays(1, &renderer_id_));
+  GLStateCache::Get().OnDeleteVertexArray(renderer_id_);
+}
+
+unsigned int VertexArray::AddFormat(const VertexBufferLayout& layout) {
   Bind();
+  unsigned int binding = (unsigned int)bindings_.size();
+  bindings_.push_back({layout.GetElements(), next_attribute_, layout.GetStride(), kNoBuffer, 0, 0});
+
+  for (const VertexBufferElement& e : layout.GetElements()) {
+    unsigned int index = next_attribute_++;
+    GLCall(glEnableVertexAttribArray(index));
+
+    if (GLAD_GL_ARB_vertex_attrib_binding) {
+      if (e.integer) {
+        GLCall(glVertexAttribIFormat(index, e.count, e.type, e.offset));
+      } else {
+        GLCall(glVertexAttribFormat(index, e.count, e.type, e.normalized, e.offset));
+      }
+      GLCall(glVertexAttribBinding(index, binding));
+    } else if (e.divisor != 0) {
+      GLCall(glVertexAttribDivisor(index, e.divisor));
+    }
+  }
+
+  if (GLAD_GL_ARB_vertex_attrib_binding && layout.GetDivisor() != 0) {
+    GLCall(glVertexBindingDivisor(binding, layout.GetDivisor()));
+  }
+  return binding;
+}
+
+void VertexArray::SetVertexBuffer(unsigned int binding, const VertexBuffer& vb, unsigned int offset) {
+  ASSERT(binding < bindings_.size());
+  Binding& b = bindings_[binding];
+  // By serial, not GL name: a buffer created after another was deleted may get the same name
+  if (b.serial == vb.GetSerial() && b.offset == offset) return;
+  b.buffer = vb.GetRendererID();
+  b.serial = vb.GetSerial();
+  b.offset = offset;
+
+  Bind();
+  if (GLAD_GL_ARB_vertex_attrib_binding) {
+    GLCall(glBindVertexBuffer(binding, b.buffer, offset, b.stride));
+    return;
+  }
+
+  // glVertexAttribPointer captures whatever GL_ARRAY_BUFFER is bound, so the format goes out again
   vb.Bind();
-  // Tell GPU buffer layout
-  const auto& elements = layout.GetElements();
-  unsigned int offset = 0;
-  for (unsigned int i = 0; i < elements.size(); i++) {
-    const auto& e = elements[i];
-
-    GLCall(glVertexAttribPointer(i, e.count, e.type, e.normalized, layout.GetStride(),
-                                 (const void*)(uintptr_t)offset));
-    GLCall(glEnableVertexAttribArray(i));
-    offset += e.count * VertexBufferElement::GetSizeOfType(e.type);
+  for (unsigned int i = 0; i < b.elements.size(); i++) {
+    const VertexBufferElement& e = b.elements[i];
+    const void* pointer = (const void*)(uintptr_t)(offset + e.offset);
+    if (e.integer) {
+      GLCall(glVertexAttribIPointer(b.first_attribute + i, e.count, e.type, b.stride, pointer));
+    } else {
+      GLCall(glVertexAttribPointer(b.first_attribute + i, e.count, e.type, e.normalized, b.stride, pointer));
+    }
   }
 }
 
-void VertexArray::Bind() const { GLCall(glBindVertexArray(renderer_id_)); }
+void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout) {
+  SetVertexBuffer(AddFormat(layout), vb);
+}
+
+void VertexArray::Bind() const { GLStateCache::Get().BindVertexArray(renderer_id_); }
 
-void VertexArray::Unbind() const { GLCall(glBindVertexArray(0)); }
+void VertexArray::Unbind() const { GLStateCache::Get().BindVertexArray(0); }
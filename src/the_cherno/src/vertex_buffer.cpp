@@ -1,14 +1,148 @@
 #include "vertex_buffer.h"
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
 #include "renderer.h"
 
-VertexBuffer::VertexBuffer(const void* data, unsigned int size) {
+static uint64_t s_next_serial = 1;
+
+static GLenum ToGLUsage(BufferUsage usage) {
+  switch (usage) {
+    case BufferUsage::kStatic:
+      return GL_STATIC_DRAW;
+    case BufferUsage::kDynamic:
+      return GL_DYNAMIC_DRAW;
+    case BufferUsage::kStream:
+      return GL_STREAM_DRAW;
+  }
+  ASSERT(false);
+  return GL_STATIC_DRAW;
+}
+
+VertexBuffer::VertexBuffer(const void* data, unsigned int size)
+    : serial_(s_next_serial++),
+      size_(size),
+      usage_(BufferUsage::kStatic),
+      region_size_(0),
+      region_index_(0),
+      head_(0),
+      mapped_base_(nullptr),
+      mapped_(false),
+      fences_{} {
   GLCall(glGenBuffers(1, &renderer_id_));
-  GLCall(glBindBuffer(GL_ARRAY_BUFFER, renderer_id_));
+  Bind();
   GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
 }
 
-VertexBuffer::~VertexBuffer() { GLCall(glDeleteBuffers(1, &renderer_id_)); }
+VertexBuffer::VertexBuffer(unsigned int size, BufferUsage usage)
+    : serial_(s_next_serial++),
+      size_(size),
+      usage_(usage),
+      region_size_(0),
+      region_index_(0),
+      head_(0),
+      mapped_base_(nullptr),
+      mapped_(false),
+      fences_{} {
+  GLCall(glGenBuffers(1, &renderer_id_));
+  Bind();
+
+  if (usage_ != BufferUsage::kStream) {
+    GLCall(glBufferData(GL_ARRAY_BUFFER, size, nullptr, ToGLUsage(usage_)));
+    return;
+  }
+
+  region_size_ = size;
+  size_ = size * kStreamRegions;
+  if (GLAD_GL_ARB_buffer_storage) {
+    // Map once for the lifetime of the buffer; coherent mapping makes writes visible without flushes
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLCall(glBufferStorage(GL_ARRAY_BUFFER, size_, nullptr, flags));
+    GLCall(mapped_base_ = glMapBufferRange(GL_ARRAY_BUFFER, 0, size_, flags));
+  } else {
+    GLCall(glBufferData(GL_ARRAY_BUFFER, size_, nullptr, GL_STREAM_DRAW));
+  }
+}
+
+VertexBuffer::~VertexBuffer() {
+  for (void* fence : fences_) {
+    if (fence) GLCall(glDeleteSync((GLsync)fence));
+  }
+  GLCall(glDeleteBuffers(1, &renderer_id_));
+  GLStateCache::Get().OnDeleteBuffer(renderer_id_);
+}
+
+void VertexBuffer::Bind() const { GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, renderer_id_); }
+
+void VertexBuffer::Unbind() const { GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, 0); }
+
+void VertexBuffer::SetData(const void* data, unsigned int size) {
+  ASSERT(usage_ != BufferUsage::kStream);
+  Bind();
+  if (size > size_) {
+    size_ = size;
+    GLCall(glBufferData(GL_ARRAY_BUFFER, size_, data, ToGLUsage(usage_)));
+    return;
+  }
+  GLCall(glBufferData(GL_ARRAY_BUFFER, size_, nullptr, ToGLUsage(usage_)));
+  GLCall(glBufferSubData(GL_ARRAY_BUFFER, 0, size, data));
+}
+
+void VertexBuffer::SubData(unsigned int offset, const void* data, unsigned int size) {
+  ASSERT(usage_ != BufferUsage::kStream);
+  ASSERT(offset + size <= size_);
+  Bind();
+  GLCall(glBufferSubData(GL_ARRAY_BUFFER, offset, size, data));
+}
+
+void* VertexBuffer::Map(unsigned int size, unsigned int alignment, unsigned int& offset) {
+  ASSERT(usage_ == BufferUsage::kStream);
+  ASSERT(!mapped_);
+  ASSERT(size <= region_size_);
+
+  unsigned int region_end = (region_index_ + 1) * region_size_;
+  offset = (head_ + alignment - 1) / alignment * alignment;
+  if (offset + size > region_end) {
+    AdvanceRegion();
+    offset = (head_ + alignment - 1) / alignment * alignment;
+    ASSERT(offset + size <= (region_index_ + 1) * region_size_);
+  }
+  head_ = offset + size;
+  mapped_ = true;
+
+  if (mapped_base_) return (char*)mapped_base_ + offset;
+
+  // The region is fenced, so the driver doesn't need to synchronize or preserve the old contents
+  void* ptr = nullptr;
+  Bind();
+  GLCall(ptr = glMapBufferRange(GL_ARRAY_BUFFER, offset, size,
+                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+  return ptr;
+}
 
-void VertexBuffer::Bind() const { GLCall(glBindBuffer(GL_ARRAY_BUFFER, renderer_id_)); }
+void VertexBuffer::Unmap() {
+  ASSERT(mapped_);
+  mapped_ = false;
+  if (mapped_base_) return;
 
-void VertexBuffer::Unbind() const { GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0)); }
+  Bind();
+  GLCall(glUnmapBuffer(GL_ARRAY_BUFFER));
+}
+
+void VertexBuffer::AdvanceRegion() {
+  // Everything issued so far may read the region being left behind
+  GLCall(fences_[region_index_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+
+  region_index_ = (region_index_ + 1) % kStreamRegions;
+  head_ = region_index_ * region_size_;
+
+  GLsync fence = (GLsync)fences_[region_index_];
+  if (!fence) return;
+
+  GLenum result = GL_TIMEOUT_EXPIRED;
+  while (result == GL_TIMEOUT_EXPIRED) {
+    GLCall(result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000));
+  }
+  ASSERT(result != GL_WAIT_FAILED);
+  GLCall(glDeleteSync(fence));
+  fences_[region_index_] = nullptr;
+}
@@ -0,0 +1,482 @@
+// Headless benchmark: runs each registered test for a fixed number of frames with vsync off and writes
+// CPU frame time percentiles, GL call counts and draw counts as JSON.
+//
+//   cherno_bench [--frames N] [--warmup N] [--test NAME]... [--out FILE] [--context osmesa|egl|native]
+//                [--width W] [--height H] [--trace FILE] [--threaded] [--workers N]
+//
+// None of the contexts need a display, except native. GLFW runs on its null platform throughout, so
+// machines without a GPU work too (Mesa's llvmpipe):
+//   egl     (default on Linux) a surfaceless EGL context rendering into an offscreen framebuffer. GLFW's
+//           own EGL backend wants window surfaces, so this one is created here with libEGL
+//   osmesa  GLFW's OSMesa backend; needs libOSMesa, which recent Mesa releases no longer ship
+//   native  a hidden window on the regular platform and driver
+// Run it from the repository root, like cherno, so assets/ resolves. Log output goes to stderr, leaving
+// stdout for the JSON. --trace also writes a Chrome trace of the whole run. --threaded runs the simulation of
+// tests that use frame packets on the FramePipeline's simulation thread. --workers sets the JobSystem's
+// worker threads, one per hardware thread but the main one by default.
+
+// clang-format off
+#include "glad/gl.h"
+#include "GLFW/glfw3.h"
+// clang-format on
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#if defined(__linux__)
+#include <dlfcn.h>
+#endif
+#include "frame_pipeline.h"
+#include "gl_extensions.h"
+#include "gl_state_cache.h"
+#include "imgui.h"
+#include "imgui_impl_glfw.h"
+#include "imgui_impl_opengl3.h"
+#include "job_system.h"
+#include "renderer.h"
+#include "shader_library.h"
+#include "test.h"
+#include "texture_loader.h"
+#include "trace_recorder.h"
+
+// Tests see the same fixed step every frame, exactly one simulation step each, so runs are comparable
+constexpr float kFrameDelta = 1.0f / 60.0f;
+// Frames allowed on top of --warmup for shaders and textures to finish loading
+constexpr int kMaxLoadFrames = 2000;
+
+struct Options {
+  int frames = 500;
+  int warmup = 30;
+  int width = 960;
+  int height = 720;
+#if defined(__linux__)
+  std::string context = "egl";
+#else
+  std::string context = "osmesa";
+#endif
+  std::string out;
+  std::string trace;
+  bool threaded = false;
+  int workers = -1;  // JobSystem::GetDefaultWorkerCount()
+  std::vector<std::string> tests;
+};
+
+struct TestResult {
+  std::string name;
+  std::vector<double> frame_ms;
+  double gl_calls = 0.0;  // all per frame
+  double binds_issued = 0.0;
+  double binds_skipped = 0.0;
+  double draw_calls = 0.0;
+  double draws = 0.0;
+};
+
+static void PrintUsage() {
+  std::cerr << "usage: cherno_bench [--frames N] [--warmup N] [--test NAME]... [--out FILE]"
+            << " [--context osmesa|egl|native] [--width W] [--height H] [--trace FILE] [--threaded]"
+            << " [--workers N]" << std::endl;
+}
+
+static bool ParseOptions(int argc, char** argv, Options& options) {
+  for (int i = 1; i < argc; i++) {
+    bool has_value = i + 1 < argc;
+    if (strcmp(argv[i], "--frames") == 0 && has_value) {
+      options.frames = std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--warmup") == 0 && has_value) {
+      options.warmup = std::max(0, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--test") == 0 && has_value) {
+      options.tests.push_back(argv[++i]);
+    } else if (strcmp(argv[i], "--out") == 0 && has_value) {
+      options.out = argv[++i];
+    } else if (strcmp(argv[i], "--context") == 0 && has_value) {
+      options.context = argv[++i];
+    } else if (strcmp(argv[i], "--width") == 0 && has_value) {
+      options.width = std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--height") == 0 && has_value) {
+      options.height = std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--trace") == 0 && has_value) {
+      options.trace = argv[++i];
+    } else if (strcmp(argv[i], "--threaded") == 0) {
+      options.threaded = true;
+    } else if (strcmp(argv[i], "--workers") == 0 && has_value) {
+      options.workers = std::max(0, atoi(argv[++i]));
+    } else {
+      return false;
+    }
+  }
+  return options.context == "osmesa" || options.context == "egl" || options.context == "native";
+}
+
+#if defined(__linux__)
+// Just enough EGL for a surfaceless context, loaded at runtime so building doesn't need EGL headers
+namespace egl {
+using Display = void*;
+using Context = void*;
+using Int = int32_t;
+
+constexpr unsigned int kPlatformSurfacelessMesa = 0x31DD;
+constexpr unsigned int kOpenGLApi = 0x30A2;
+constexpr Int kContextMajorVersion = 0x3098;
+constexpr Int kContextMinorVersion = 0x30FB;
+constexpr Int kContextOpenGLProfileMask = 0x30FD;
+constexpr Int kContextOpenGLCoreProfileBit = 0x1;
+constexpr Int kNone = 0x3038;
+
+using GetProcAddressFn = GLADapiproc (*)(const char* name);
+using GetPlatformDisplayFn = Display (*)(unsigned int platform, void* native_display, const Int* attribs);
+using InitializeFn = unsigned int (*)(Display display, Int* major, Int* minor);
+using BindAPIFn = unsigned int (*)(unsigned int api);
+using CreateContextFn = Context (*)(Display display, void* config, Context share, const Int* attribs);
+using MakeCurrentFn = unsigned int (*)(Display display, void* draw, void* read, Context context);
+using DestroyContextFn = unsigned int (*)(Display display, Context context);
+using TerminateFn = unsigned int (*)(Display display);
+
+static void* s_library = nullptr;
+static GetProcAddressFn s_get_proc_address = nullptr;
+static Display s_display = nullptr;
+static Context s_context = nullptr;
+
+template <typename T>
+static T Load(const char* name) {
+  return (T)dlsym(s_library, name);
+}
+
+static GLADapiproc GetProcAddress(const char* name) { return s_get_proc_address(name); }
+
+static bool CreateContext() {
+  s_library = dlopen("libEGL.so.1", RTLD_LAZY | RTLD_LOCAL);
+  if (!s_library) return false;
+  s_get_proc_address = Load<GetProcAddressFn>("eglGetProcAddress");
+  auto get_platform_display = (GetPlatformDisplayFn)s_get_proc_address("eglGetPlatformDisplayEXT");
+  auto initialize = Load<InitializeFn>("eglInitialize");
+  auto bind_api = Load<BindAPIFn>("eglBindAPI");
+  auto create_context = Load<CreateContextFn>("eglCreateContext");
+  auto make_current = Load<MakeCurrentFn>("eglMakeCurrent");
+  if (!get_platform_display || !initialize || !bind_api || !create_context || !make_current) return false;
+
+  Int major = 0, minor = 0;
+  s_display = get_platform_display(kPlatformSurfacelessMesa, nullptr, nullptr);
+  if (!s_display || !initialize(s_display, &major, &minor) || !bind_api(kOpenGLApi)) return false;
+
+  // No config and no surface (KHR_no_config_context, KHR_surfaceless_context); drawing goes to an FBO
+  const Int attribs[] = {kContextMajorVersion, 3, kContextMinorVersion, 3, kContextOpenGLProfileMask,
+                         kContextOpenGLCoreProfileBit, kNone};
+  s_context = create_context(s_display, nullptr, nullptr, attribs);
+  return s_context && make_current(s_display, nullptr, nullptr, s_context);
+}
+
+static void DestroyContext() {
+  if (s_context) {
+    Load<MakeCurrentFn>("eglMakeCurrent")(s_display, nullptr, nullptr, nullptr);
+    Load<DestroyContextFn>("eglDestroyContext")(s_display, s_context);
+  }
+  if (s_display) Load<TerminateFn>("eglTerminate")(s_display);
+  if (s_library) dlclose(s_library);
+}
+}  // namespace egl
+#endif
+
+// A GLFW window, for ImGui's input and display size, and a current GL context. With surfaceless EGL the
+// window has no context of its own and frames are drawn into `framebuffer`
+struct BenchContext {
+  GLFWwindow* window = nullptr;
+  GLADloadfunc load = nullptr;
+  bool surfaceless = false;
+  unsigned int framebuffer = 0;
+  unsigned int color = 0;
+  unsigned int depth = 0;
+};
+
+static void GlfwErrorCallback(int error, const char* description) {
+  std::cerr << "Glfw error " << error << ": " << description << std::endl;
+}
+
+static bool CreateContext(const Options& options, BenchContext& context) {
+  glfwSetErrorCallback(GlfwErrorCallback);
+  if (options.context != "native") {
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+  }
+  if (!glfwInit()) return false;
+
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  if (options.context == "osmesa") {
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+  } else if (options.context == "egl") {
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    context.surfaceless = true;
+  }
+
+  context.window = glfwCreateWindow(options.width, options.height, "cherno_bench", NULL, NULL);
+  if (!context.window) return false;
+
+  if (!context.surfaceless) {
+    glfwMakeContextCurrent(context.window);
+    glfwSwapInterval(0);
+    context.load = glfwGetProcAddress;
+    return true;
+  }
+#if defined(__linux__)
+  if (!egl::CreateContext()) {
+    std::cerr << "EGL: Failed to create a surfaceless context" << std::endl;
+    return false;
+  }
+  context.load = egl::GetProcAddress;
+  return true;
+#else
+  std::cerr << "EGL: surfaceless contexts are only supported on Linux" << std::endl;
+  return false;
+#endif
+}
+
+// Stands in for the default framebuffer, which a surfaceless context doesn't have
+static void CreateFramebuffer(const Options& options, BenchContext& context) {
+  GLCall(glGenRenderbuffers(1, &context.color));
+  GLCall(glBindRenderbuffer(GL_RENDERBUFFER, context.color));
+  GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, options.width, options.height));
+  GLCall(glGenRenderbuffers(1, &context.depth));
+  GLCall(glBindRenderbuffer(GL_RENDERBUFFER, context.depth));
+  GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, options.width, options.height));
+
+  GLCall(glGenFramebuffers(1, &context.framebuffer));
+  GLCall(glBindFramebuffer(GL_FRAMEBUFFER, context.framebuffer));
+  GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, context.color));
+  GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, context.depth));
+  ASSERT(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+  GLCall(glViewport(0, 0, options.width, options.height));
+}
+
+static void DestroyContext(BenchContext& context) {
+  if (context.framebuffer) {
+    GLCall(glDeleteFramebuffers(1, &context.framebuffer));
+    GLCall(glDeleteRenderbuffers(1, &context.color));
+    GLCall(glDeleteRenderbuffers(1, &context.depth));
+  }
+#if defined(__linux__)
+  if (context.surfaceless) egl::DestroyContext();
+#endif
+  if (context.window) glfwDestroyWindow(context.window);
+  glfwTerminate();
+}
+
+// One frame the way cherno's main loop runs it, minus the menu
+static void RunFrame(const BenchContext& context, FramePipeline& pipeline, test::Test& test) {
+  TRACE_SCOPE("Frame");
+  Renderer renderer;
+  renderer.Clear();
+
+  ImGui_ImplOpenGL3_NewFrame();
+  ImGui_ImplGlfw_NewFrame();
+  ImGui::NewFrame();
+  ShaderLibrary::Get().Update();
+  TextureLoader::Get().Update();
+  {
+    TRACE_SCOPE("Test UI");
+    pipeline.Sync();
+    ImGui::Begin("Test");
+    test.OnImGuiRender();
+    ImGui::End();
+  }
+  {
+    TRACE_SCOPE("Run frame");
+    pipeline.RunFrame(test, kFrameDelta);
+  }
+  {
+    TRACE_SCOPE("ImGui");
+    ImGui::Render();
+    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  }
+
+  GLStateCache::Get().EndFrame();
+  if (!context.surfaceless) glfwSwapBuffers(context.window);
+  glfwPollEvents();
+}
+
+static TestResult RunTest(const BenchContext& context, FramePipeline& pipeline, const std::string& name,
+                          const test::TestMenu::Factory& factory, const Options& options) {
+  std::cerr << "Running " << name << std::endl;
+  TestResult result;
+  result.name = name;
+  test::Test* test = factory();
+
+  // Past the warmup, keep going until nothing is loading in the background any more
+  for (int frame = 0; frame < options.warmup + kMaxLoadFrames; frame++) {
+    bool loading = ShaderLibrary::Get().GetPendingCount() != 0 || TextureLoader::Get().GetPendingCount() != 0;
+    if (frame >= options.warmup && !loading) break;
+    RunFrame(context, pipeline, *test);
+  }
+  glFinish();
+
+  uint64_t gl_calls = 0, binds_issued = 0, binds_skipped = 0;
+  Renderer::ResetStats();
+  result.frame_ms.reserve(options.frames);
+  for (int frame = 0; frame < options.frames; frame++) {
+    uint64_t calls_before = GLCallCount();
+    auto start = std::chrono::steady_clock::now();
+    RunFrame(context, pipeline, *test);
+    // Without vsync the driver can queue frames; finishing charges each frame with its own GPU work
+    glFinish();
+    auto end = std::chrono::steady_clock::now();
+
+    result.frame_ms.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    gl_calls += GLCallCount() - calls_before;
+    binds_issued += GLStateCache::Get().GetLastFrameCounters().issued;
+    binds_skipped += GLStateCache::Get().GetLastFrameCounters().skipped;
+  }
+
+  double frames = (double)options.frames;
+  result.gl_calls = gl_calls / frames;
+  result.binds_issued = binds_issued / frames;
+  result.binds_skipped = binds_skipped / frames;
+  result.draw_calls = Renderer::GetStats().draw_calls / frames;
+  result.draws = Renderer::GetStats().draws / frames;
+
+  pipeline.Discard();
+  delete test;
+  return result;
+}
+
+// Nearest-rank percentile of sorted values
+static double Percentile(const std::vector<double>& sorted, double p) {
+  size_t rank = (size_t)std::ceil(p / 100.0 * sorted.size());
+  return sorted[std::min(sorted.size() - 1, rank == 0 ? 0 : rank - 1)];
+}
+
+static std::string JsonString(const std::string& value) {
+  std::string out = "\"";
+  for (char c : value) {
+    if (c == '"' || c == '\\') out += '\\';
+    out += c;
+  }
+  return out + "\"";
+}
+
+static void WriteJson(std::ostream& out, const Options& options, const std::vector<TestResult>& results) {
+  out << "{\n";
+  out << "  \"gl_vendor\": " << JsonString((const char*)glGetString(GL_VENDOR)) << ",\n";
+  out << "  \"gl_renderer\": " << JsonString((const char*)glGetString(GL_RENDERER)) << ",\n";
+  out << "  \"gl_version\": " << JsonString((const char*)glGetString(GL_VERSION)) << ",\n";
+  out << "  \"context\": " << JsonString(options.context) << ",\n";
+  out << "  \"width\": " << options.width << ",\n";
+  out << "  \"height\": " << options.height << ",\n";
+  out << "  \"frames\": " << options.frames << ",\n";
+  out << "  \"threaded\": " << (options.threaded ? "true" : "false") << ",\n";
+  out << "  \"workers\": " << JobSystem::Get().GetWorkerCount() << ",\n";
+  out << "  \"tests\": [";
+  for (size_t i = 0; i < results.size(); i++) {
+    const TestResult& r = results[i];
+    std::vector<double> sorted = r.frame_ms;
+    std::sort(sorted.begin(), sorted.end());
+    double mean = 0.0;
+    for (double ms : sorted) mean += ms;
+    mean /= sorted.size();
+
+    out << (i == 0 ? "\n" : ",\n");
+    out << "    {\n";
+    out << "      \"name\": " << JsonString(r.name) << ",\n";
+    out << "      \"frame_ms\": {\"mean\": " << mean << ", \"min\": " << sorted.front()
+        << ", \"p50\": " << Percentile(sorted, 50) << ", \"p90\": " << Percentile(sorted, 90)
+        << ", \"p99\": " << Percentile(sorted, 99) << ", \"max\": " << sorted.back() << "},\n";
+    out << "      \"per_frame\": {\"gl_calls\": " << r.gl_calls << ", \"binds_issued\": " << r.binds_issued
+        << ", \"binds_skipped\": " << r.binds_skipped << ", \"draw_calls\": " << r.draw_calls
+        << ", \"draws\": " << r.draws << "}\n";
+    out << "    }";
+  }
+  out << "\n  ]\n}\n";
+}
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, options)) {
+    PrintUsage();
+    return 1;
+  }
+
+  // Everything the library logs goes to stderr; stdout is for the report
+  std::streambuf* stdout_buffer = std::cout.rdbuf(std::cerr.rdbuf());
+
+  BenchContext context;
+  if (!CreateContext(options, context)) {
+    std::cerr << "Failed to create a " << options.context << " context" << std::endl;
+    DestroyContext(context);
+    return 1;
+  }
+  if (gladLoadGL(context.load) == 0) {
+    std::cerr << "Glad: Failed to initialize OpenGL context" << std::endl;
+    DestroyContext(context);
+    return 1;
+  }
+  LoadGLExtensions(context.load);
+  std::cerr << "Context: " << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << std::endl;
+#if GL_ERROR_POLICY == GL_ERROR_POLICY_DEBUG_OUTPUT
+  GLEnableDebugOutput();
+#endif
+
+  if (context.surfaceless) CreateFramebuffer(options, context);
+
+  ImGui::CreateContext();
+  ImGui::GetIO().IniFilename = nullptr;  // don't leave an imgui.ini behind
+  ImGui_ImplGlfw_InitForOpenGL(context.window, false);
+  ImGui_ImplOpenGL3_Init("#version 330");
+
+  test::Test* current_test = nullptr;
+  test::TestMenu menu(current_test);
+  test::RegisterTests(menu);
+
+  TraceRecorder& trace = TraceRecorder::Get();
+  trace.SetThreadName("Main");
+  if (!options.trace.empty()) trace.Start();
+
+  JobSystem& jobs = JobSystem::Get();
+  jobs.Start(options.workers < 0 ? JobSystem::GetDefaultWorkerCount() : (unsigned int)options.workers);
+
+  FramePipeline pipeline;
+  pipeline.SetThreaded(options.threaded);
+
+  std::vector<TestResult> results;
+  for (const auto& [name, factory] : menu.GetTests()) {
+    bool selected = options.tests.empty() ||
+                    std::find(options.tests.begin(), options.tests.end(), name) != options.tests.end();
+    if (!selected) continue;
+    results.push_back(RunTest(context, pipeline, name, factory, options));
+  }
+
+  if (!options.trace.empty()) {
+    trace.Stop();
+    if (trace.Dump(options.trace)) {
+      std::cerr << "Wrote " << options.trace << std::endl;
+    } else {
+      std::cerr << "Failed to write " << options.trace << std::endl;
+    }
+  }
+
+  std::cout.rdbuf(stdout_buffer);
+  if (options.out.empty()) {
+    WriteJson(std::cout, options, results);
+  } else {
+    std::ofstream file(options.out);
+    WriteJson(file, options, results);
+    std::cerr << "Wrote " << options.out << std::endl;
+  }
+
+  pipeline.Shutdown();
+  jobs.Shutdown();
+  ShaderLibrary::Get().Clear();
+  TextureLoader::Get().Shutdown();
+  ImGui_ImplOpenGL3_Shutdown();
+  ImGui_ImplGlfw_Shutdown();
+  ImGui::DestroyContext();
+  DestroyContext(context);
+  return results.empty() ? 1 : 0;
+}
@@ -0,0 +1,243 @@
+// CPU benchmark of the JobSystem: times one frame of a sprite workload with 1 to N threads and writes how it
+// scales as JSON. A frame is a transform update that moves every sprite along its own orbit, then the
+// culling and vertex generation BatchRenderer2D::SubmitQuads runs, so no GL context is needed.
+//
+//   job_bench [--sprites N] [--frames N] [--warmup N] [--threads N] [--out FILE]
+//
+// Thread counts include the main thread, which helps while it waits: 1 runs every job inline, N starts N-1
+// workers. --threads defaults to the hardware threads. Each run reports the mean frame and per-stage times,
+// its speedup over one thread and a checksum of the last frame's vertices, which must match across runs.
+// Before timing anything it checks CullSprites against a plain loop, and fails if they disagree.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "batch_renderer_2d.h"
+#include "job_system.h"
+
+// The world the sprites orbit in is twice the view on each side, so about a quarter of them are visible
+constexpr float kViewWidth = 1280.0f;
+constexpr float kViewHeight = 720.0f;
+constexpr size_t kTransformGrain = 4096;
+
+struct Options {
+  size_t sprites = 100000;
+  int frames = 200;
+  int warmup = 20;
+  unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+  std::string out;
+};
+
+struct Orbit {
+  glm::vec2 center;
+  float radius;
+  float speed;
+  float phase;
+};
+
+struct RunResult {
+  unsigned int threads = 0;
+  size_t visible = 0;
+  uint64_t checksum = 0;
+  std::vector<double> frame_ms;
+  double transform_ms = 0.0;  // means
+  double cull_ms = 0.0;
+  double vertices_ms = 0.0;
+};
+
+static void PrintUsage() {
+  std::cerr << "usage: job_bench [--sprites N] [--frames N] [--warmup N] [--threads N] [--out FILE]" << std::endl;
+}
+
+static bool ParseOptions(int argc, char** argv, Options& options) {
+  for (int i = 1; i < argc; i++) {
+    bool has_value = i + 1 < argc;
+    if (strcmp(argv[i], "--sprites") == 0 && has_value) {
+      options.sprites = (size_t)std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--frames") == 0 && has_value) {
+      options.frames = std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--warmup") == 0 && has_value) {
+      options.warmup = std::max(0, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--threads") == 0 && has_value) {
+      options.threads = (unsigned int)std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--out") == 0 && has_value) {
+      options.out = argv[++i];
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Same sprites every run, so the checksums compare
+static std::vector<Orbit> CreateOrbits(size_t count) {
+  std::vector<Orbit> orbits(count);
+  uint32_t seed = 1;
+  auto next = [&seed]() {
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8) / 16777216.0f;
+  };
+  for (Orbit& orbit : orbits) {
+    orbit.center = glm::vec2((next() * 2.0f - 0.5f) * kViewWidth, (next() * 2.0f - 0.5f) * kViewHeight);
+    orbit.radius = 8.0f + next() * 64.0f;
+    orbit.speed = 0.5f + next() * 2.0f;
+    orbit.phase = next() * 6.2831853f;
+  }
+  return orbits;
+}
+
+static void MoveSprites(const std::vector<Orbit>& orbits, size_t first, size_t last, float time,
+                        std::vector<BatchRenderer2D::Sprite>& sprites) {
+  for (size_t i = first; i < last; i++) {
+    const Orbit& orbit = orbits[i];
+    float angle = orbit.phase + time * orbit.speed;
+    BatchRenderer2D::Sprite& sprite = sprites[i];
+    sprite.position = orbit.center + orbit.radius * glm::vec2(std::cos(angle), std::sin(angle));
+    sprite.size = glm::vec2(16.0f);
+    sprite.color = glm::vec4(std::fmod(angle, 1.0f), orbit.radius / 72.0f, 0.8f, 1.0f);
+  }
+}
+
+// Culls with workers and then without into the same vector, for all sprites and then fewer, the way the
+// renderer's scratch vector sees worker and quad count changes
+static bool CheckCulling(const std::vector<Orbit>& orbits, unsigned int threads) {
+  std::vector<BatchRenderer2D::Sprite> sprites(orbits.size());
+  MoveSprites(orbits, 0, orbits.size(), 0.0f, sprites);
+  const glm::vec2 view_min(0.0f), view_max(kViewWidth, kViewHeight);
+
+  std::vector<uint32_t> visible;
+  for (size_t count : {sprites.size(), sprites.size() / 2 + 1}) {
+    std::vector<uint32_t> expected;
+    for (size_t i = 0; i < count; i++) {
+      const BatchRenderer2D::Sprite& sprite = sprites[i];
+      if (sprite.position.x <= view_max.x && sprite.position.y <= view_max.y &&
+          sprite.position.x + sprite.size.x >= view_min.x && sprite.position.y + sprite.size.y >= view_min.y) {
+        expected.push_back((uint32_t)i);
+      }
+    }
+    for (unsigned int workers : {threads - 1, 0u}) {
+      JobSystem::Get().Start(workers);
+      size_t listed = BatchRenderer2D::CullSprites(sprites.data(), count, view_min, view_max, nullptr, visible);
+      if (listed != expected.size() || !std::equal(expected.begin(), expected.end(), visible.begin())) {
+        std::cerr << "CullSprites is wrong for " << count << " sprites and " << workers << " workers" << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static double Milliseconds(std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end) {
+  return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+static RunResult Run(const Options& options, const std::vector<Orbit>& orbits, unsigned int threads) {
+  JobSystem& jobs = JobSystem::Get();
+  jobs.Start(threads - 1);
+
+  std::vector<BatchRenderer2D::Sprite> sprites(orbits.size());
+  std::vector<uint32_t> visible;
+  std::vector<QuadVertex> vertices(orbits.size() * 4);
+  const glm::vec2 view_min(0.0f), view_max(kViewWidth, kViewHeight);
+
+  RunResult result;
+  result.threads = threads;
+  for (int frame = -options.warmup; frame < options.frames; frame++) {
+    // Fixed frame times, so every run draws the same frames
+    float time = std::max(frame, 0) / 60.0f;
+
+    auto begin = std::chrono::steady_clock::now();
+    jobs.ParallelFor(sprites.size(), kTransformGrain,
+                     [&](size_t first, size_t last) { MoveSprites(orbits, first, last, time, sprites); });
+    auto transformed = std::chrono::steady_clock::now();
+    size_t count = BatchRenderer2D::CullSprites(sprites.data(), sprites.size(), view_min, view_max, nullptr, visible);
+    auto culled = std::chrono::steady_clock::now();
+    BatchRenderer2D::WriteSprites(sprites.data(), visible.data(), count, nullptr, vertices.data());
+    auto end = std::chrono::steady_clock::now();
+
+    if (frame < 0) continue;
+    result.frame_ms.push_back(Milliseconds(begin, end));
+    result.transform_ms += Milliseconds(begin, transformed) / options.frames;
+    result.cull_ms += Milliseconds(transformed, culled) / options.frames;
+    result.vertices_ms += Milliseconds(culled, end) / options.frames;
+    result.visible = count;
+  }
+
+  // FNV-1a over the last frame's quads, member bytes only: the copies WriteQuad makes can leave anything in
+  // the padding at the end of a vertex
+  constexpr size_t kVertexBytes = offsetof(QuadVertex, tex_index) + sizeof(QuadVertex::tex_index);
+  result.checksum = 14695981039346656037ull;
+  for (size_t v = 0; v < result.visible * 4; v++) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&vertices[v]);
+    for (size_t i = 0; i < kVertexBytes; i++) result.checksum = (result.checksum ^ bytes[i]) * 1099511628211ull;
+  }
+  return result;
+}
+
+static double Mean(const std::vector<double>& values) {
+  double sum = 0.0;
+  for (double value : values) sum += value;
+  return sum / values.size();
+}
+
+static void WriteJson(std::ostream& out, const Options& options, const std::vector<RunResult>& results) {
+  double base = Mean(results.front().frame_ms);
+  out << "{\n";
+  out << "  \"sprites\": " << options.sprites << ",\n";
+  out << "  \"frames\": " << options.frames << ",\n";
+  out << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+  out << "  \"runs\": [";
+  for (size_t i = 0; i < results.size(); i++) {
+    const RunResult& r = results[i];
+    std::vector<double> sorted = r.frame_ms;
+    std::sort(sorted.begin(), sorted.end());
+    double mean = Mean(sorted);
+    out << (i == 0 ? "\n" : ",\n");
+    out << "    {\"threads\": " << r.threads << ", \"visible\": " << r.visible << ", \"checksum\": \"" << std::hex
+        << r.checksum << std::dec << "\",\n";
+    out << "     \"frame_ms\": {\"mean\": " << mean << ", \"min\": " << sorted.front()
+        << ", \"p50\": " << sorted[sorted.size() / 2] << ", \"max\": " << sorted.back() << "},\n";
+    out << "     \"stage_ms\": {\"transform\": " << r.transform_ms << ", \"cull\": " << r.cull_ms
+        << ", \"vertices\": " << r.vertices_ms << "}, \"speedup\": " << base / mean << "}";
+  }
+  out << "\n  ]\n}\n";
+}
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, options)) {
+    PrintUsage();
+    return 1;
+  }
+
+  std::vector<Orbit> orbits = CreateOrbits(options.sprites);
+  if (!CheckCulling(orbits, options.threads)) return 1;
+
+  std::vector<RunResult> results;
+  for (unsigned int threads = 1; threads <= options.threads; threads++) {
+    results.push_back(Run(options, orbits, threads));
+    const RunResult& r = results.back();
+    std::cerr << r.threads << " threads: " << Mean(r.frame_ms) << " ms" << std::endl;
+    if (r.checksum != results.front().checksum) {
+      std::cerr << "Warning: the vertices differ from the single threaded run" << std::endl;
+    }
+  }
+  JobSystem::Get().Shutdown();
+
+  if (options.out.empty()) {
+    WriteJson(std::cout, options, results);
+  } else {
+    std::ofstream file(options.out);
+    WriteJson(file, options, results);
+    std::cerr << "Wrote " << options.out << std::endl;
+  }
+  return 0;
+}
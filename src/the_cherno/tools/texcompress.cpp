@@ -0,0 +1,101 @@
+// Offline texture compressor: encodes a PNG/JPEG (anything stb_image reads) into a block compressed
+// KTX file with a precomputed mip chain, ready for Texture / TextureLoader.
+//
+//   texcompress <input> <output.ktx> [--format bc1|bc3|bc7|etc2|etc2a] [--no-mips]
+//
+// Without --format, opaque images become BC1 and images with alpha BC3. ETC2 is meant for GLES
+// targets; desktop drivers accept it too but usually decompress it on upload.
+
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "ktx_file.h"
+#include "mipmap.h"
+#include "stb_image.h"
+
+static void PrintUsage() {
+  std::cout << "usage: texcompress <input> <output.ktx> [--format bc1|bc3|bc7|etc2|etc2a] [--no-mips]" << std::endl;
+}
+
+static bool ParseFormat(const std::string& name, BlockFormat& format) {
+  if (name == "bc1") {
+    format = BlockFormat::kBC1;
+  } else if (name == "bc3") {
+    format = BlockFormat::kBC3;
+  } else if (name == "bc7") {
+    format = BlockFormat::kBC7;
+  } else if (name == "etc2") {
+    format = BlockFormat::kETC2_RGB;
+  } else if (name == "etc2a") {
+    format = BlockFormat::kETC2_RGBA;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static bool HasAlpha(const uint8_t* pixels, int width, int height) {
+  for (size_t i = 0; i < (size_t)width * height; i++) {
+    if (pixels[i * 4 + 3] != 0xff) return true;
+  }
+  return false;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    PrintUsage();
+    return 1;
+  }
+  std::string input = argv[1], output = argv[2];
+  bool has_format = false, mips = true;
+  BlockFormat format = BlockFormat::kBC1;
+  for (int i = 3; i < argc; i++) {
+    if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+      if (!ParseFormat(argv[++i], format)) {
+        std::cout << "unknown format " << argv[i] << std::endl;
+        return 1;
+      }
+      has_format = true;
+    } else if (strcmp(argv[i], "--no-mips") == 0) {
+      mips = false;
+    } else {
+      PrintUsage();
+      return 1;
+    }
+  }
+
+  // Texture flips images on load, so the blocks are encoded bottom row first as well
+  stbi_set_flip_vertically_on_load(1);
+  int width, height, channels;
+  uint8_t* pixels = stbi_load(input.c_str(), &width, &height, &channels, 4);
+  if (!pixels) {
+    std::cout << "failed to load " << input << ": " << stbi_failure_reason() << std::endl;
+    return 1;
+  }
+  if (!has_format) format = HasAlpha(pixels, width, height) ? BlockFormat::kBC3 : BlockFormat::kBC1;
+
+  CompressedImage image;
+  image.format = format;
+  image.width = width;
+  image.height = height;
+  image.levels.push_back({width, height, CompressImage(format, pixels, width, height)});
+  if (mips) {
+    for (const MipLevel& mip : GenerateMipChain(pixels, width, height)) {
+      image.levels.push_back({mip.width, mip.height, CompressImage(format, mip.pixels.data(), mip.width, mip.height)});
+    }
+  }
+  stbi_image_free(pixels);
+
+  if (!WriteKtx(output, image)) {
+    std::cout << "failed to write " << output << std::endl;
+    return 1;
+  }
+
+  size_t rgba_size = 0;
+  for (const CompressedImage::Level& level : image.levels) rgba_size += (size_t)level.width * level.height * 4;
+  std::cout << output << ": " << GetBlockFormatName(format) << ", " << width << "x" << height << ", "
+            << image.levels.size() << " levels, " << image.GetSize() << " bytes, " << std::setprecision(2)
+            << (double)rgba_size / image.GetSize() << "x smaller than RGBA8" << std::endl;
+  return 0;
+}